@@ -0,0 +1,187 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#include "AllocationCounter.h"
+
+#if defined(COUNT_ALLOCATIONS)
+// Replaces the global allocation functions of the whole program, so only
+// builds meant for soak runs and allocation checks define it.
+static std::atomic<std::int64_t> allocations{0};
+static std::atomic<std::int64_t> deallocations{0};
+
+static void *countedAlloc(size_t size)
+{
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  return std::malloc(size ? size : 1);
+}
+
+static void countedFree(void *p)
+{
+  if (!p)
+    return;
+  deallocations.fetch_add(1, std::memory_order_relaxed);
+  std::free(p);
+}
+
+void *operator new(size_t size)
+{
+  if (void *p = countedAlloc(size))
+    return p;
+  throw std::bad_alloc{};
+}
+
+void *operator new[](size_t size) { return operator new(size); }
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+  return countedAlloc(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+  return countedAlloc(size);
+}
+
+void operator delete(void *p) noexcept { countedFree(p); }
+
+void operator delete[](void *p) noexcept { countedFree(p); }
+
+void operator delete(void *p, size_t) noexcept { countedFree(p); }
+
+void operator delete[](void *p, size_t) noexcept { countedFree(p); }
+
+void operator delete(void *p, const std::nothrow_t &) noexcept
+{
+  countedFree(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t &) noexcept
+{
+  countedFree(p);
+}
+
+#if defined(__cpp_aligned_new)
+// The block is allocated with room for the alignment, the pointer malloc
+// returned is kept right before the aligned one.
+static void *countedAlignedAlloc(size_t size, std::align_val_t alignment)
+{
+  const size_t align = std::max(static_cast<size_t>(alignment),
+                                alignof(void *));
+  void *block = countedAlloc(size + align + sizeof(void *));
+  if (!block)
+    return nullptr;
+  std::uintptr_t aligned =
+      (reinterpret_cast<std::uintptr_t>(block) + sizeof(void *) + align - 1) &
+      ~(align - 1);
+  reinterpret_cast<void **>(aligned)[-1] = block;
+  return reinterpret_cast<void *>(aligned);
+}
+
+static void countedAlignedFree(void *p)
+{
+  if (p)
+    countedFree(static_cast<void **>(p)[-1]);
+}
+
+void *operator new(size_t size, std::align_val_t alignment)
+{
+  if (void *p = countedAlignedAlloc(size, alignment))
+    return p;
+  throw std::bad_alloc{};
+}
+
+void *operator new[](size_t size, std::align_val_t alignment)
+{
+  return operator new(size, alignment);
+}
+
+void *operator new(size_t size, std::align_val_t alignment,
+                   const std::nothrow_t &) noexcept
+{
+  return countedAlignedAlloc(size, alignment);
+}
+
+void *operator new[](size_t size, std::align_val_t alignment,
+                     const std::nothrow_t &) noexcept
+{
+  return countedAlignedAlloc(size, alignment);
+}
+
+void operator delete(void *p, std::align_val_t) noexcept
+{
+  countedAlignedFree(p);
+}
+
+void operator delete[](void *p, std::align_val_t) noexcept
+{
+  countedAlignedFree(p);
+}
+
+void operator delete(void *p, size_t, std::align_val_t) noexcept
+{
+  countedAlignedFree(p);
+}
+
+void operator delete[](void *p, size_t, std::align_val_t) noexcept
+{
+  countedAlignedFree(p);
+}
+
+void operator delete(void *p, std::align_val_t,
+                     const std::nothrow_t &) noexcept
+{
+  countedAlignedFree(p);
+}
+
+void operator delete[](void *p, std::align_val_t,
+                       const std::nothrow_t &) noexcept
+{
+  countedAlignedFree(p);
+}
+#endif
+#endif
+
+bool AllocationCounter::isCounting()
+{
+#if defined(COUNT_ALLOCATIONS)
+  return true;
+#else
+  return false;
+#endif
+}
+
+void AllocationCounter::countAllocation()
+{
+#if defined(COUNT_ALLOCATIONS)
+  allocations.fetch_add(1, std::memory_order_relaxed);
+#endif
+}
+
+void AllocationCounter::countDeallocation()
+{
+#if defined(COUNT_ALLOCATIONS)
+  deallocations.fetch_add(1, std::memory_order_relaxed);
+#endif
+}
+
+std::int64_t AllocationCounter::getCount()
+{
+#if defined(COUNT_ALLOCATIONS)
+  return allocations.load(std::memory_order_relaxed);
+#else
+  return -1;
+#endif
+}
+
+std::int64_t AllocationCounter::getLiveCount()
+{
+#if defined(COUNT_ALLOCATIONS)
+  return allocations.load(std::memory_order_relaxed) -
+         deallocations.load(std::memory_order_relaxed);
+#else
+  return -1;
+#endif
+}
@@ -0,0 +1,28 @@
+#ifndef ALLOCATION_COUNTER_H__
+#define ALLOCATION_COUNTER_H__
+
+#include <cstdint>
+
+/// Counts the heap allocations of the whole program. Builds with
+/// COUNT_ALLOCATIONS replace all global operator new and delete overloads
+/// for that, including the nothrow and aligned ones, in all other builds the
+/// counts are -1. Code that takes memory from malloc directly counts it with
+/// countAllocation.
+class AllocationCounter
+{
+public:
+  /// True if the allocations are counted in this build.
+  static bool isCounting();
+
+  /// Counts an allocation that bypasses operator new, and its release.
+  static void countAllocation();
+  static void countDeallocation();
+
+  /// Allocations so far, or -1 if not counted.
+  static std::int64_t getCount();
+
+  /// Allocations that were not freed yet, or -1 if not counted.
+  static std::int64_t getLiveCount();
+};
+
+#endif // ALLOCATION_COUNTER_H__
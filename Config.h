@@ -1,8 +1,18 @@
 #ifndef CONFIG_H__
 #define CONFIG_H__
 
+// collision policies, see GameSimulation.h
+struct ColumnCollision;
+struct BruteForceCollision;
+
+/// Compile time configuration of the game. BasicGameEngine is specialized
+/// for a configuration, so all of its values are known to the compiler.
 struct Config
 {
+  /// Numeric type of positions and bounding boxes.
+  using Scalar = float;
+  /// Finds the enemy a rocket hits.
+  using Collision = ColumnCollision;
   static const int MAX_ROCKET_COUNT{10};
   static const int MAX_BOMB_COUNT{10};
   static const int ENEMY_COUNT{50};
@@ -11,10 +21,79 @@ struct Config
   static const int PLAYER_HEALTH{3};
   static constexpr double TIME_BETWEEN_SHOTS{0.25};
   static constexpr double TIME_BETWEEN_BOMBS{0.35};
+  /// Interval of frames written to disk if a capture is started.
+  static const int CAPTURE_EVERY_NTH_FRAME{2};
+  /// Frames taking longer are counted as hitches.
+  static constexpr double HITCH_SECONDS{1.0 / 30};
+  /// Interval of metric exports, if enabled.
+  static constexpr double METRICS_EXPORT_SECONDS{5.0};
+  /// Input sequences a LookaheadBot tries per decision.
+  static const int BOT_CANDIDATES{32};
+  /// Ticks a LookaheadBot plays each candidate ahead. Rockets need about
+  /// 200 ticks to reach the enemies.
+  static const int BOT_LOOKAHEAD_TICKS{240};
+  /// Length of a tick played ahead.
+  static constexpr double BOT_TICK_SECONDS{1.0 / 60};
+  /// Interval of keyframes streamed to spectators, in ticks.
+  static const int SPECTATOR_KEYFRAME_TICKS{120};
+  /// Fractional bits of the fixed point coordinates sent to spectators, 4
+  /// bits give a 1/16 pixel resolution.
+  static const int SPECTATOR_POSITION_FRACTION_BITS{4};
+  /// Game time the allocation check lets pass before it counts, e.g. the
+  /// countdown and the arenas growing to the texts of the game.
+  static constexpr double ALLOCATION_CHECK_WARMUP_SECONDS{10.0};
+  /// Draw the player, enemies, rockets and bombs.
+  static const bool DRAW_SCENE{true};
+  /// Draw health, scores, fps and state messages.
+  static const bool DRAW_HUD{true};
 
   // assert guarantees
   static_assert(float(ENEMY_COUNT) / ENEMY_ROWS == ENEMY_COUNT / ENEMY_ROWS,
                 "ENEMY_COUNT must be dividable by ENEMY_ROWS");
 };
 
+/// Configuration without any drawing, e.g. for servers and automated runs.
+/// The draw functions compile away.
+struct HeadlessConfig : Config
+{
+  static const bool DRAW_SCENE{false};
+  static const bool DRAW_HUD{false};
+};
+
+/// Configuration of the stress mode (see StressTest): full pools, short
+/// cooldowns and a player that survives many hits.
+struct StressConfig : HeadlessConfig
+{
+  static const int MAX_ROCKET_COUNT{64};
+  static const int MAX_BOMB_COUNT{64};
+  static const int PLAYER_HEALTH{100};
+  static constexpr double TIME_BETWEEN_SHOTS{0.02};
+  static constexpr double TIME_BETWEEN_BOMBS{0.02};
+};
+
+/// The values of Config that are not array sizes as variables, so they are
+/// only known at run time. Only used to measure what the specialization on
+/// Config gains (see StressTest::compareConfigs), which also defines them.
+struct RuntimeConfig : Config
+{
+  static int ENEMY_ROWS;
+  static int ENEMY_COLS;
+  static int PLAYER_HEALTH;
+  static double TIME_BETWEEN_SHOTS;
+  static double TIME_BETWEEN_BOMBS;
+};
+
+/// Config with double positions, to measure the numeric type.
+struct DoubleConfig : Config
+{
+  using Scalar = double;
+};
+
+/// Config that checks rockets against every enemy, to measure the collision
+/// policy.
+struct BruteForceConfig : Config
+{
+  using Collision = BruteForceCollision;
+};
+
 #endif // CONFIG_H__
@@ -0,0 +1,77 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "AllocationCounter.h"
+#include "FrameArena.h"
+
+const unsigned char FrameArena::POISON;
+
+/// Size of the overflow header, keeps the payload maximally aligned.
+static const size_t OVERFLOW_HEADER{alignof(std::max_align_t)};
+
+FrameArena::FrameArena(size_t capacity)
+    : _buffer(new unsigned char[capacity]), _capacity(capacity)
+{
+}
+
+FrameArena::~FrameArena() { reset(); }
+
+void *FrameArena::allocate(size_t size, size_t alignment)
+{
+  std::uintptr_t base = reinterpret_cast<std::uintptr_t>(_buffer.get());
+  std::uintptr_t aligned = (base + _used + alignment - 1) & ~(alignment - 1);
+  size_t end = aligned - base + size;
+  if (end <= _capacity)
+  {
+    _used = end;
+    return reinterpret_cast<void *>(aligned);
+  }
+
+  // does not fit, take it from the heap until the next reset. The
+  // allocation check counts it like any other heap allocation.
+  ++_overflowCount;
+  AllocationCounter::countAllocation();
+  _overflowUsed += size + alignment;
+  void *block = std::malloc(OVERFLOW_HEADER + size + alignment);
+  if (!block)
+    throw std::bad_alloc{};
+  Overflow *overflow = static_cast<Overflow *>(block);
+  overflow->next = _overflow;
+  _overflow = overflow;
+
+  std::uintptr_t payload =
+      reinterpret_cast<std::uintptr_t>(block) + OVERFLOW_HEADER;
+  return reinterpret_cast<void *>((payload + alignment - 1) &
+                                  ~(alignment - 1));
+}
+
+void FrameArena::reset()
+{
+  _highWaterMark = std::max(_highWaterMark, getUsed());
+
+#if !defined(NDEBUG)
+  memset(_buffer.get(), POISON, _used);
+#endif
+
+  while (_overflow)
+  {
+    Overflow *next = _overflow->next;
+    std::free(_overflow);
+    AllocationCounter::countDeallocation();
+    _overflow = next;
+  }
+
+  // grow once (with some slack for alignment), so the next frames of the
+  // same size fit
+  if (_overflowUsed > 0)
+  {
+    _capacity = _highWaterMark + _highWaterMark / 4;
+    _buffer.reset(new unsigned char[_capacity]);
+  }
+
+  _used = 0;
+  _overflowUsed = 0;
+}
@@ -0,0 +1,135 @@
+#ifndef FRAME_ARENA_H__
+#define FRAME_ARENA_H__
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#define FRAME_ARENA_PMR
+#endif
+#endif
+
+/// Linear allocator for data that only lives for one frame (hud texts, draw
+/// lists, ...). Allocating is a pointer bump, deallocating does nothing and
+/// reset releases everything at once.
+///
+/// If a frame needs more than the capacity, the rest is taken from the heap
+/// and the arena grows to the high water mark on the next reset. After a few
+/// frames the steady state does not touch the heap at all. Debug builds
+/// overwrite released memory, so data used after its frame stands out.
+class FrameArena
+{
+public:
+  explicit FrameArena(size_t capacity = 64 * 1024);
+  ~FrameArena();
+
+  FrameArena(const FrameArena &) = delete;
+  FrameArena &operator=(const FrameArena &) = delete;
+
+  void *allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+  /// Releases all allocations of the frame.
+  void reset();
+
+  /// Bytes allocated in the current frame.
+  size_t getUsed() const { return _used + _overflowUsed; }
+
+  /// Most bytes ever allocated in one frame.
+  size_t getHighWaterMark() const { return _highWaterMark; }
+
+  size_t getCapacity() const { return _capacity; }
+
+  /// Number of allocations that did not fit and went to the heap.
+  int getOverflowCount() const { return _overflowCount; }
+
+  static const unsigned char POISON{0xCD};
+
+private:
+  /// Heap block of an allocation that did not fit into the arena.
+  struct Overflow
+  {
+    Overflow *next;
+  };
+
+  std::unique_ptr<unsigned char[]> _buffer;
+  size_t _capacity{0};
+  size_t _used{0};
+  size_t _overflowUsed{0};
+  size_t _highWaterMark{0};
+  Overflow *_overflow{nullptr};
+  int _overflowCount{0};
+};
+
+/// Standard allocator on top of a frame arena, e.g. for strings and vectors
+/// that are thrown away at the end of the frame.
+template <typename T>
+class ArenaAllocator
+{
+public:
+  using value_type = T;
+
+  explicit ArenaAllocator(FrameArena &arena) : _arena(&arena) {}
+
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U> &o) : _arena(o._arena)
+  {
+  }
+
+  T *allocate(size_t n)
+  {
+    return static_cast<T *>(_arena->allocate(n * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T *, size_t) {}
+
+  template <typename U>
+  bool operator==(const ArenaAllocator<U> &o) const
+  {
+    return _arena == o._arena;
+  }
+
+  template <typename U>
+  bool operator!=(const ArenaAllocator<U> &o) const
+  {
+    return _arena != o._arena;
+  }
+
+private:
+  template <typename U>
+  friend class ArenaAllocator;
+
+  FrameArena *_arena;
+};
+
+using FrameString =
+    std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>>;
+
+#if defined(FRAME_ARENA_PMR)
+/// Polymorphic memory resource on top of a frame arena, for std::pmr
+/// containers.
+class FrameArenaResource : public std::pmr::memory_resource
+{
+public:
+  explicit FrameArenaResource(FrameArena &arena) : _arena(arena) {}
+
+private:
+  void *do_allocate(size_t bytes, size_t alignment) override
+  {
+    return _arena.allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void *, size_t, size_t) override {}
+
+  bool do_is_equal(const std::pmr::memory_resource &o) const noexcept override
+  {
+    return this == &o;
+  }
+
+  FrameArena &_arena;
+};
+#endif
+
+#endif // FRAME_ARENA_H__
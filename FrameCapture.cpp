@@ -0,0 +1,256 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#include "FrameCapture.h"
+
+const int FrameCapture::BUFFER_COUNT;
+
+using Pixel = SoftwareRenderer::Pixel;
+
+static unsigned char red(Pixel p) { return (p >> 16) & 0xFF; }
+static unsigned char green(Pixel p) { return (p >> 8) & 0xFF; }
+static unsigned char blue(Pixel p) { return p & 0xFF; }
+static unsigned char alpha(Pixel p) { return (p >> 24) & 0xFF; }
+
+static unsigned char clampByte(int value)
+{
+  return static_cast<unsigned char>(value < 0 ? 0
+                                                : (value > 255 ? 255 : value));
+}
+
+static std::uint32_t crc32(const unsigned char *data, size_t size,
+                           std::uint32_t crc = 0)
+{
+  static std::array<std::uint32_t, 256> table = [] {
+    std::array<std::uint32_t, 256> t{};
+    for (std::uint32_t n = 0; n < 256; ++n)
+    {
+      std::uint32_t c = n;
+      for (int k = 0; k < 8; ++k)
+        c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+      t[n] = c;
+    }
+    return t;
+  }();
+
+  crc = ~crc;
+  for (size_t i = 0; i < size; ++i)
+    crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+  return ~crc;
+}
+
+static void appendBigEndian(std::vector<unsigned char> &out,
+                            std::uint32_t value)
+{
+  out.push_back((value >> 24) & 0xFF);
+  out.push_back((value >> 16) & 0xFF);
+  out.push_back((value >> 8) & 0xFF);
+  out.push_back(value & 0xFF);
+}
+
+/// Starts a chunk in out, its data is appended after the call. Returns the
+/// offset of the chunk for endPngChunk.
+static size_t beginPngChunk(std::vector<unsigned char> &out, const char *type)
+{
+  size_t offset = out.size();
+  appendBigEndian(out, 0); // length, set by endPngChunk
+  out.insert(out.end(), type, type + 4);
+  return offset;
+}
+
+/// Sets the length of the chunk and appends its CRC.
+static void endPngChunk(std::vector<unsigned char> &out, size_t offset)
+{
+  const size_t typeOffset = offset + 4;
+  const std::uint32_t length =
+      static_cast<std::uint32_t>(out.size() - typeOffset - 4);
+  for (int i = 0; i < 4; ++i)
+    out[offset + i] = (length >> (24 - i * 8)) & 0xFF;
+  appendBigEndian(out, crc32(out.data() + typeOffset, length + 4));
+}
+
+FrameCapture::FrameCapture(const std::string &path, CAPTURE_FORMAT format,
+                           int everyNthFrame, MetricsRegistry &metrics)
+    : _path(path), _format(format),
+      _everyNthFrame(everyNthFrame > 0 ? everyNthFrame : 1), _metrics(metrics)
+{
+  for (Frame &frame : _frames)
+  {
+    frame.pixels.resize(Engine::CanvasWidth * Engine::CanvasHeight);
+    _free.push(&frame);
+  }
+
+  // the images are written through a buffer of the capture, the file
+  // stream would allocate its own with every file
+  _image.rdbuf()->pubsetbuf(_imageBuffer.data(), _imageBuffer.size());
+  _imagePath.reserve(_path.size() + 32);
+
+  if (_format == CAPTURE_FORMAT::Y4M)
+  {
+    _video.open(_path, std::ios::binary);
+    _video << "YUV4MPEG2 W" << Engine::CanvasWidth << " H"
+           << Engine::CanvasHeight << " F60:" << _everyNthFrame
+           << " Ip A1:1 C444\n";
+  }
+
+  _writer = std::thread{&FrameCapture::run, this};
+}
+
+FrameCapture::~FrameCapture()
+{
+  // the writer drains all filled buffers before it stops
+  _running = false;
+  _writer.join();
+}
+
+void FrameCapture::capture(const SoftwareRenderer &renderer)
+{
+  if (_frameNumber++ % _everyNthFrame != 0)
+    return;
+
+  Frame *frame{nullptr};
+  if (!_free.pop(frame))
+  {
+    // writer fell behind, never wait for it
+    _metrics.add(METRIC::CAPTURE_DROPPED_FRAMES);
+    return;
+  }
+
+  frame->number = _frameNumber - 1;
+  memcpy(frame->pixels.data(), renderer.getPixels(),
+         frame->pixels.size() * sizeof(SoftwareRenderer::Pixel));
+  _filled.push(frame);
+  _metrics.add(METRIC::CAPTURED_FRAMES);
+}
+
+void FrameCapture::run()
+{
+  Frame *frame{nullptr};
+  while (true)
+  {
+    if (_filled.pop(frame))
+    {
+      write(*frame);
+      _free.push(frame);
+    }
+    else if (!_running)
+    {
+      // the last frame may have been filled after the pop above but before
+      // stopping, every push happened before _running turned false
+      while (_filled.pop(frame))
+      {
+        write(*frame);
+        _free.push(frame);
+      }
+      break;
+    }
+    else
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+  _video.flush();
+}
+
+void FrameCapture::write(const Frame &frame)
+{
+  if (_format == CAPTURE_FORMAT::Y4M)
+    writeY4m(frame);
+  else
+    writePng(frame);
+}
+
+void FrameCapture::writeY4m(const Frame &frame)
+{
+  // full resolution Y, Cb and Cr planes (BT.601)
+  const size_t planeSize = frame.pixels.size();
+  _encoded.resize(planeSize * 3);
+  unsigned char *y = _encoded.data();
+  unsigned char *cb = y + planeSize;
+  unsigned char *cr = cb + planeSize;
+  for (size_t i = 0; i < planeSize; ++i)
+  {
+    int r = red(frame.pixels[i]);
+    int g = green(frame.pixels[i]);
+    int b = blue(frame.pixels[i]);
+    y[i] = clampByte(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+    cb[i] = clampByte(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+    cr[i] = clampByte(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+  }
+
+  _video << "FRAME\n";
+  _video.write(reinterpret_cast<const char *>(_encoded.data()),
+               _encoded.size());
+}
+
+void FrameCapture::writePng(const Frame &frame)
+{
+  const int width = Engine::CanvasWidth;
+  const int height = Engine::CanvasHeight;
+
+  // raw image data, every row starts with filter type 0
+  _raw.resize(height * (1 + width * 4));
+  unsigned char *raw = _raw.data();
+  for (int row = 0; row < height; ++row)
+  {
+    *raw++ = 0;
+    for (int col = 0; col < width; ++col)
+    {
+      SoftwareRenderer::Pixel p = frame.pixels[row * width + col];
+      *raw++ = red(p);
+      *raw++ = green(p);
+      *raw++ = blue(p);
+      *raw++ = alpha(p);
+    }
+  }
+
+  // the buffers keep their capacity, after the first frame no chunk touches
+  // the heap
+  _encoded.assign({0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'});
+
+  size_t chunk = beginPngChunk(_encoded, "IHDR");
+  appendBigEndian(_encoded, width);
+  appendBigEndian(_encoded, height);
+  _encoded.insert(_encoded.end(), {8, 6, 0, 0, 0}); // 8 bit RGBA, no interlace
+  endPngChunk(_encoded, chunk);
+
+  // zlib stream with stored (uncompressed) deflate blocks, which keeps the
+  // writer free of a compression library
+  chunk = beginPngChunk(_encoded, "IDAT");
+  _encoded.insert(_encoded.end(), {0x78, 0x01});
+  std::uint32_t adlerA{1};
+  std::uint32_t adlerB{0};
+  for (size_t offset = 0; offset < _raw.size();)
+  {
+    size_t length = std::min<size_t>(_raw.size() - offset, 65535);
+    bool last = offset + length == _raw.size();
+    _encoded.insert(_encoded.end(),
+                    {static_cast<unsigned char>(last ? 1 : 0),
+                     static_cast<unsigned char>(length & 0xFF),
+                     static_cast<unsigned char>((length >> 8) & 0xFF),
+                     static_cast<unsigned char>(~length & 0xFF),
+                     static_cast<unsigned char>((~length >> 8) & 0xFF)});
+    const unsigned char *block = _raw.data() + offset;
+    _encoded.insert(_encoded.end(), block, block + length);
+    for (size_t i = 0; i < length; ++i)
+    {
+      adlerA = (adlerA + block[i]) % 65521;
+      adlerB = (adlerB + adlerA) % 65521;
+    }
+    offset += length;
+  }
+  appendBigEndian(_encoded, (adlerB << 16) | adlerA);
+  endPngChunk(_encoded, chunk);
+
+  endPngChunk(_encoded, beginPngChunk(_encoded, "IEND"));
+
+  char suffix[32];
+  snprintf(suffix, sizeof(suffix), "_%06d.png", frame.number);
+  _imagePath.assign(_path).append(suffix);
+  _image.open(_imagePath, std::ios::binary);
+  _image.write(reinterpret_cast<const char *>(_encoded.data()),
+               _encoded.size());
+  _image.close();
+}
@@ -0,0 +1,86 @@
+#ifndef FRAME_CAPTURE_H__
+#define FRAME_CAPTURE_H__
+
+#include <array>
+#include <atomic>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Metrics.h"
+#include "SoftwareRenderer.h"
+#include "SpscRing.h"
+
+/// File format of a capture.
+enum class CAPTURE_FORMAT : int
+{
+  Y4M, // one raw YUV 4:4:4 video file
+  PNG  // one uncompressed image file per frame
+};
+
+/// Writes every n-th frame of the software renderer to disk. Frames are
+/// copied into recycled buffers and handed to a writer thread, so the game
+/// loop never waits for encoding or file I/O. If all buffers are in use, the
+/// frame is dropped. Captured and dropped frames are counted in the metrics.
+class FrameCapture
+{
+public:
+  /// @param path File of the video for Y4M. For PNG the frame number and
+  /// extension are appended, e.g. "capture" becomes "capture_000042.png".
+  /// @param format File format of the capture.
+  /// @param everyNthFrame Interval of captured frames, 1 captures all.
+  FrameCapture(const std::string &path, CAPTURE_FORMAT format,
+               int everyNthFrame, MetricsRegistry &metrics);
+  ~FrameCapture();
+
+  FrameCapture(const FrameCapture &) = delete;
+  FrameCapture &operator=(const FrameCapture &) = delete;
+
+  /// Captures the current framebuffer if this frame is due. Meant to be
+  /// called once per frame after SoftwareRenderer::present.
+  void capture(const SoftwareRenderer &renderer);
+
+private:
+  static const int BUFFER_COUNT{8};
+
+  struct Frame
+  {
+    int number{0};
+    std::vector<SoftwareRenderer::Pixel> pixels;
+  };
+
+  using FrameRing = SpscRing<Frame *, BUFFER_COUNT>;
+
+  void run();
+  void write(const Frame &frame);
+  void writeY4m(const Frame &frame);
+  void writePng(const Frame &frame);
+
+  const std::string _path;
+  const CAPTURE_FORMAT _format;
+  const int _everyNthFrame;
+  MetricsRegistry &_metrics;
+
+  int _frameNumber{0};
+
+  std::array<Frame, BUFFER_COUNT> _frames;
+  /// buffers ready to be filled by the game loop
+  FrameRing _free;
+  /// buffers ready to be written by the writer thread
+  FrameRing _filled;
+
+  std::ofstream _video;
+  /// Encoding buffers of the writer thread, reused for every frame
+  std::vector<unsigned char> _raw;
+  std::vector<unsigned char> _encoded;
+  /// File of the current PNG image and its buffer
+  std::ofstream _image;
+  std::array<char, 4096> _imageBuffer;
+  std::string _imagePath;
+
+  std::atomic<bool> _running{true};
+  std::thread _writer;
+};
+
+#endif // FRAME_CAPTURE_H__
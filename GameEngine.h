@@ -1,187 +1,191 @@
 #ifndef GAME_ENGINE_H__
 #define GAME_ENGINE_H__
 
-#include <random>
+#include <memory>
+#include <string>
 
 #include "Engine.h"
-#include "GameObjects.h"
-
-/// State of the game at any given time.
-enum class GAMESTATE : int
+#include "FrameArena.h"
+#include "GameSimulation.h"
+#include "InputQueue.h"
+#include "LatencyStats.h"
+#include "LookaheadBot.h"
+#include "Metrics.h"
+#include "SceneCanvas.h"
+#include "SpectatorStream.h"
+#include "TimerWheel.h"
+
+#if defined(SOFTWARE_RENDERER)
+#include "FrameCapture.h"
+#include "SoftwareRenderer.h"
+#endif
+
+/// Timers of the game, see BasicGameEngine::onTimer.
+enum class GAMETIMER : int
 {
-  WELCOME,
-  WELCOME_3,
-  WELCOME_2,
-  WELCOME_1,
-  GO,
-  PLAY,
-  GAMEOVER,
-  TRYAGAIN
+  FPS_WINDOW,
+  METRICS_SNAPSHOT,
+  COUNTDOWN,
+  GAMEOVER_PROMPT,
+  COUNT
 };
 
-/// Flag used when scene is resetted.
-enum class RESET : int
+/// The game, specialized for a configuration (see Config). Use the
+/// GameEngine alias for the default configuration.
+template <typename Cfg = Config>
+class BasicGameEngine : private Engine
 {
-  BUT_NOT_THE_PLAYER,
-  ALSO_PLAYER_POSITION,
-};
+public:
+	using Engine::getStopwatchElapsedSeconds;
 
-/// The travel direction of all enemies.
-enum class ENEMY_DIRECTION : int
-{
-  LEFT,
-  RIGHT
-};
+  BasicGameEngine();
+  ~BasicGameEngine();
 
-/// Bounding box with absolute integer values.
-struct BoundingBox
-{
-  float left{0};
-  float top{0};
-  float right{0};
-  float bottom{0};
-
-  /// Checks if a game object position is in a bounding box.
-  /// @param o Game object to check.
-  bool intersectsWith(const GameObject& o) const;
-
-  /// Move the bounding box towards a given position.
-  /// @param pos The position to move the bounding box. Can be negative or
-  /// positive.
-  void moveBy(const Position& pos);
-};
+  /// Starts a new frame and releases the transient data of the previous one.
+  /// Returns false if the game should quit.
+  bool startFrame();
 
-/// High score object that handles points. It can read and write the highscore
-/// from and to disk.
-class Highscore
-{
-public:
-  /// Adds a point to the score list.
-  void addScore();
+  /// Function to handle events, meant to be used in game loop only.
+  void handleEvents();
 
-  /// Finishs a round. Does not write the score to disk, must be called
-  /// explicitly.
-  void finishScore();
+  /// Function to update the game scene. Meant to be used in game loop only.
+  void update();
 
-  /// Gets the absolute highscore of all games.
-  int getHighscore() const;
+  /// Function to draw the scene to the canvas. Meant to be used in game loop
+  /// only.
+  void draw();
 
-  /// Gets the score of the current game.
-  int getCurrentScore() const;
+  /// Time from the timestamp of a key event to the end of the draw() after
+  /// handleEvents processed it. Polled keys are stamped at the start of
+  /// handleEvents, so this is the time from handleEvents to the end of draw.
+  /// Backend events also include their wait in the queue. The time until
+  /// the frame shows on the display is not included.
+  LatencyStats::Percentiles getInputLatency() const
+  {
+    return _inputLatency.getPercentiles();
+  }
 
-  /// Writes the highest score (depending if the current, or previous highscore
-  /// is higher) to disk. The file the score is written to is
-  /// "spaceinvaders.hscore".
-  void writeToDisk() const;
+  /// Metrics for monitoring, see MetricsRegistry::startExporter.
+  MetricsRegistry &getMetrics() { return _metrics; }
 
-  /// Reads the highscore from the file "spaceinvaders.hscore" if it exists.
-  void readFromDisk();
+  /// Allocator of all data that only lives for one frame.
+  const FrameArena &getFrameArena() const { return _frameArena; }
 
-public:
-  const int _fileversion{1};
-  int _currentScore{0};
-  int _oldHighscore{0};
-};
+  /// Lets a LookaheadBot play instead of the keyboard. It plays through
+  /// polled keys, so not after useInputEvents.
+  /// @param threads Threads looking ahead, including the game thread.
+  void startBot(int threads);
 
-class GameEngine : private Engine
-{
-public:
-	using Engine::getStopwatchElapsedSeconds;
-  using Engine::startFrame;
+  /// Takes the key events of a backend instead of polling the engine. Call
+  /// it before the game loop starts, the backend then pushes to the returned
+  /// queue and is its only producer (see InputQueue).
+  InputQueue &useInputEvents();
 
-  GameEngine();
-  ~GameEngine();
+  /// Returns the playing bot, or nullptr.
+  const LookaheadBot<Cfg> *getBot() const { return _bot.get(); }
 
-  /// Function to handle events, meant to be used in game loop only.
-  void handleEvents();
+  /// Streams every tick to a SpectatorViewer listening on a Unix domain
+  /// socket.
+  void startSpectatorStream(const std::string &path);
 
-  /// Function to update the game scene. Meant to be used in game loop only.
-  void update();
+#if defined(SOFTWARE_RENDERER)
+  /// The renderer the scene is drawn to. The host has to provide the sprite
+  /// and glyph images.
+  SoftwareRenderer &getRenderer() { return _renderer; }
 
-  /// Function to draw the scene to the canvas. Meant to be used in game loop
-  /// only.
-  void draw();
+  /// Writes every Cfg::CAPTURE_EVERY_NTH_FRAME frame to disk. Paths ending
+  /// with ".png" write an image sequence, all others a Y4M video.
+  void startCapture(const std::string &path);
+
+  /// Returns the running capture, or nullptr.
+  const FrameCapture *getCapture() const { return _capture.get(); }
+#endif
 
 private:
-  /// Resets the game. Is used for instance on startup, or to restart the game
-  /// after game is lost.
-  /// @param reset		Used to reset entire scene. Player position can be
-  /// excluded with corresponding flag
-  void resetGame(RESET reset = RESET::ALSO_PLAYER_POSITION);
-
-  /// Initializes the players position. Does not set the health.
-  void initPlayer();
-  /// Sets the position and health of all enemies.
-  void initEnemies();
-  /// Resets all rocket objects and sets them to non-alive.
-  void initRockets();
-  /// Resets all bombs and sets them to non-alive.
-  void initBombs();
+  /// Keys of the player, or of the bot if one is playing.
+  Engine::PlayerInput readPlayerInput();
+
+  /// Reacts to the fire key being pressed, either shoots or restarts the game.
+  /// @param timestamp Time the key was pressed.
+  void handleFirePressed(double timestamp);
+
+  /// Updates the gauges of the metrics.
+  void snapshotMetrics();
+
+  /// Reacts to an expired timer.
+  void onTimer(GAMETIMER timer);
+
+  /// Ends the game and schedules the prompt to try again.
+  void gameOver();
 
   /// Draws the hud. Is used inside the ::Draw function during game loop.
   void drawHud();
-  /// Draws the player object. Is used inside the ::Draw function during game
-  /// loop.
-  void drawPlayer();
-  /// Draws all enemies. Is used inside the ::Draw function during game loop.
-  void drawEnemies();
-  /// Draws all rockets. Is used inside the ::Draw function during game loop.
-  void drawRockets();
-  /// Draws all bombs. Is used inside the ::Draw function during game loop.
-  void drawBombs();
-
-  /// Takes actions on enemies. Resets enemies if they left the canvas
-  /// (according to the bounding box). Also removes health from player if  the
-  /// player if an enemy hit the player. Also destroys an enemy, if it got hit
-  /// by a rocket.
-  void updateEnemies();
-  /// Takes actions on rockets. Sends them in travel direction. Also destroys
-  /// them if they left the canvas.
-  void updateRockets();
-  /// Takes actions on bombs. Destroys them if they left the canvas. Subtracts
-  /// health point from player if hit. Also sends bombs from enemies in a
-  /// n-interval towards y axis.
-  void updateBombs();
-
-  /// Game state, level info and travel direction of enemies
+  /// Draws the player, enemies, rockets and bombs. Is used inside the ::Draw
+  /// function during game loop.
+  void drawScene();
+
+  /// Game state
   GAMESTATE _gamestate{GAMESTATE::WELCOME};
-  ENEMY_DIRECTION _enemy_direction{ENEMY_DIRECTION::RIGHT};
-  Highscore _hscore;
-  int _level{1};
 
   /// Timestamps and fps information
-  double _startTimestamp{0.0};
   double _previousTimestamp{0.0};
   double _currentTimestamp{0.0};
-  double _timestampOfLastShot{0.0};
-  double _timestampOfLastBomb{0.0};
-  double _timestampOfLastFpsCalc{0.0};
   double _timestampOfLastFireKey{0.0};
-  double _timestampOfGameOver{0.0};
   double _msPerFrame{0.0};
   int _framesCount{0};
   int _fps{60};
 
-  /// Is true if the user lifted the
-  /// fire button/key in the last frame
-  bool _liftedFireKeyBefore{true};
+  /// Deadlines of countdown, fps window, metrics and game over prompt.
+  /// The flag is set when the corresponding timer expires.
+  TimerWheel<GAMETIMER, static_cast<int>(GAMETIMER::COUNT)> _timers;
+  bool _showTryAgainPrompt{false};
+
+  /// Frame times, phase timings and gauges of the game
+  MetricsRegistry _metrics;
+
+  /// Transient data of the current frame, reset in startFrame
+  FrameArena _frameArena;
 
-  /// Scene objects + bounding box of enemies
-  Player _player;
-  RocketArray _rockets;
-  BombArray _bombs;
-  EnemyArray _enemies;
+  /// Key events and the resulting key states
+  InputQueue _inputQueue;
+  Engine::PlayerInput _keys{};
 
-  /// Bounding box encloses only aliens that are alive.
-  BoundingBox _enemyBbox;
+  /// Oldest processed key event that is not yet reflected by a drawn frame
+  bool _inputPending{false};
+  double _timestampOfPendingInput{0.0};
+  LatencyStats _inputLatency;
 
-  /// Original bounding box used to determine where rocket hits which column.
-  /// Does enclose all aliens, no matter if destroyed or not
-  BoundingBox _enemyBboxOriginal;
+  /// Scene objects, score and cooldowns
+  GameSimulation<Cfg> _sim;
 
-  /// Random generator for index of enemies dropping bombs
-  std::default_random_engine _rd;
-  std::uniform_int_distribution<int> _dis;
+  /// Plays instead of the keyboard if started
+  std::unique_ptr<LookaheadBot<Cfg>> _bot;
+
+  /// Sends the ticks to a viewer if started
+  std::unique_ptr<SpectatorPublisher<Cfg>> _spectators;
+
+#if defined(SOFTWARE_RENDERER)
+  /// Headless framebuffer, replaces the drawing of the engine
+  SoftwareRenderer _renderer;
+  std::unique_ptr<FrameCapture> _capture;
+
+  /// Draws to the software renderer
+  SceneCanvas _canvas{*this, _frameArena, _renderer};
+#else
+  /// Draws with the engine
+  SceneCanvas _canvas{*this, _frameArena};
+#endif
 };
 
+// defined and instantiated in GameEngine.cpp
+extern template class BasicGameEngine<Config>;
+extern template class BasicGameEngine<HeadlessConfig>;
+
+// builds with -DHEADLESS play without drawing, e.g. on servers
+#if defined(HEADLESS)
+using GameEngine = BasicGameEngine<HeadlessConfig>;
+#else
+using GameEngine = BasicGameEngine<Config>;
+#endif
+
 #endif // GAME_ENGINE_H__
@@ -3,71 +3,235 @@
 
 #include <array>
 #include <cmath>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 #include "Config.h"
 #include "Engine.h"
 #include "GameObjects.h"
 
-struct Position
+/// Position of a game object, in pixels. The scalar is the numeric type of
+/// the configuration (Config::Scalar).
+template <typename Scalar>
+struct BasicPosition
 {
-  float _x{0};
-  float _y{0};
+  Scalar _x{0};
+  Scalar _y{0};
 };
 
-class GameObject
+using Position = BasicPosition<float>;
+
+/// Game objects only keep their position, 8 bytes with float instead of the
+/// 12 bytes with a health. Whether an enemy, rocket or bomb is alive is
+/// tracked by the alive mask of its ObjectPool, only the player has a
+/// health.
+///
+/// The game uses float positions: objects move by a step per update that
+/// gets very small at high frame rates (e.g. 0.015 pixels for a bomb at 10000
+/// fps), a fixed point position with a coarse resolution would round such
+/// steps away.
+template <typename S>
+class BasicGameObject
 {
 public:
+  using Scalar = S;
+  using Position = BasicPosition<Scalar>;
+
   constexpr void setPosition(Position pos) { _pos = pos; }
 
   Position getPosition() const { return _pos; }
 
-  void setPositionX(float posX) { _pos._x = posX; }
-
-  void setPositionY(float posY) { _pos._y = posY; }
-
-  void destroy() { setHealth(0); }
-
-  constexpr void setHealth(int health) { _health = health; }
-
-  void hit() { --_health; }
-
-  bool isAlive() const { return _health > 0; }
+  void setPositionX(Scalar posX) { _pos._x = posX; }
 
-  int getHealth() const { return _health; }
+  void setPositionY(Scalar posY) { _pos._y = posY; }
 
-  bool intersectsWith(const GameObject &o,
-                      float radius = Engine::SpriteSize / 2) const
+  bool intersectsWith(const BasicGameObject &o,
+                      Scalar radius = Engine::SpriteSize / 2) const
   {
-    float dx = (_pos._x - o._pos._x);
-    float dy = (_pos._y - o._pos._y);
+    Scalar dx = (_pos._x - o._pos._x);
+    Scalar dy = (_pos._y - o._pos._y);
     return sqrt(dx * dx + dy * dy) <= radius;
   }
 
 protected:
   Position _pos;
-  int _health{0};
 };
 
-class Enemy : public GameObject
+using GameObject = BasicGameObject<float>;
+
+static_assert(sizeof(GameObject) == 8, "game objects must stay packed");
+
+/// Returns the index of the lowest set bit. The mask must not be 0.
+inline int countTrailingZeros(std::uint64_t mask)
 {
-};
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctzll(mask);
+#elif defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward64(&index, mask);
+  return static_cast<int>(index);
+#else
+  int index{0};
+  while (!(mask & 1))
+  {
+    mask >>= 1;
+    ++index;
+  }
+  return index;
+#endif
+}
 
-using EnemyArray = std::array<Enemy, Config::ENEMY_COUNT>;
+/// Returns the number of set bits.
+inline int countSetBits(std::uint64_t mask)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_popcountll(mask);
+#elif defined(_MSC_VER)
+  return static_cast<int>(__popcnt64(mask));
+#else
+  int count{0};
+  for (; mask; mask &= mask - 1)
+    ++count;
+  return count;
+#endif
+}
+
+/// Range over the indices of all set bits of a 64 bit mask, lowest first.
+/// The mask is copied, so objects can be destroyed while iterating.
+class AliveIndices
+{
+public:
+  class iterator
+  {
+  public:
+    explicit iterator(std::uint64_t mask) : _mask(mask) {}
+
+    int operator*() const { return countTrailingZeros(_mask); }
+
+    iterator &operator++()
+    {
+      _mask &= _mask - 1; // clears the lowest set bit
+      return *this;
+    }
+
+    bool operator!=(const iterator &o) const { return _mask != o._mask; }
+
+  private:
+    std::uint64_t _mask;
+  };
 
-class Bomb : public GameObject
+  explicit AliveIndices(std::uint64_t mask) : _mask(mask) {}
+
+  iterator begin() const { return iterator{_mask}; }
+  iterator end() const { return iterator{0}; }
+
+private:
+  std::uint64_t _mask;
+};
+
+/// Fixed size pool of game objects. Whether an object is alive is tracked in
+/// a 64 bit mask next to the objects, so loops only visit alive objects and
+/// checks like "any object alive" are a single compare. The mask is the only
+/// alive state, positions of objects that are not alive are stale.
+template <typename T, int SIZE>
+class ObjectPool
 {
+  static_assert(
+      std::is_base_of<BasicGameObject<typename T::Scalar>, T>::value,
+      "only supports objects of type GameObject");
+  static_assert(SIZE > 0 && SIZE <= 64, "alive mask supports 64 objects");
+
+public:
+  static constexpr int size() { return SIZE; }
+
+  T &operator[](int i) { return _objects[i]; }
+  const T &operator[](int i) const { return _objects[i]; }
+
+  bool isAlive(int i) const { return (_alive & bit(i)) != 0; }
+
+  /// Returns true if at least one object is alive.
+  bool any() const { return _alive != 0; }
+
+  /// Number of alive objects.
+  int count() const { return countSetBits(_alive); }
+
+  std::uint64_t aliveMask() const { return _alive; }
+
+  /// Indices of all alive objects.
+  AliveIndices alive() const { return AliveIndices{_alive}; }
+
+  /// Indices of all objects that are not alive.
+  AliveIndices freeSlots() const { return AliveIndices{freeMask()}; }
+
+  std::uint64_t freeMask() const { return ~_alive & FULL_MASK; }
+
+  /// Returns the index of the first object that is not alive, or -1 if all
+  /// objects are in use.
+  int firstFree() const
+  {
+    std::uint64_t mask = ~_alive & FULL_MASK;
+    return mask ? countTrailingZeros(mask) : -1;
+  }
+
+  /// Places the object at the given position and sets it alive.
+  void spawn(int i, typename T::Position pos)
+  {
+    _objects[i].setPosition(pos);
+    _alive |= bit(i);
+  }
+
+  void destroy(int i) { _alive &= ~bit(i); }
+
+  void destroyAll() { _alive = 0; }
+
+private:
+  static constexpr std::uint64_t FULL_MASK =
+      SIZE == 64 ? ~std::uint64_t{0} : (std::uint64_t{1} << SIZE) - 1;
+
+  static constexpr std::uint64_t bit(int i) { return std::uint64_t{1} << i; }
+
+  std::array<T, SIZE> _objects{};
+  std::uint64_t _alive{0};
 };
 
-using BombArray = std::array<Bomb, Config::MAX_BOMB_COUNT>;
+template <typename Scalar>
+class BasicEnemy : public BasicGameObject<Scalar>
+{
+};
 
-class Rocket : public GameObject
+template <typename Scalar>
+class BasicBomb : public BasicGameObject<Scalar>
 {
 };
 
-using RocketArray = std::array<Rocket, Config::MAX_ROCKET_COUNT>;
+template <typename Scalar>
+class BasicRocket : public BasicGameObject<Scalar>
+{
+};
 
-class Player : public GameObject
+template <typename Scalar>
+class BasicPlayer : public BasicGameObject<Scalar>
 {
+public:
+  void setHealth(int health) { _health = health; }
+
+  void hit() { --_health; }
+
+  bool isAlive() const { return _health > 0; }
+
+  int getHealth() const { return _health; }
+
+private:
+  int _health{0};
 };
 
+using Enemy = BasicEnemy<float>;
+using Bomb = BasicBomb<float>;
+using Rocket = BasicRocket<float>;
+using Player = BasicPlayer<float>;
+
 #endif // GAMEOBJECTS_H__
@@ -0,0 +1,530 @@
+#include <fstream>
+#include <limits>
+#include <type_traits>
+
+#include "GameSimulation.h"
+
+#if __cplusplus > \
+    201703L // thats my general way to ensure todos don't get ignored for long
+#define CPP20
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define likely(x) __builtin_expect(!!(x), 1)
+#define unlikely(x) __builtin_expect(!!(x), 0)
+#else
+#define likely(x) x
+#define unlikely(x) x
+#endif
+
+template <typename Scalar>
+bool BasicBoundingBox<Scalar>::intersectsWith(
+    const BasicGameObject<Scalar> &o) const
+{
+  BasicPosition<Scalar> pos = o.getPosition();
+  return (pos._x >= left && pos._x <= right && pos._y >= top &&
+          pos._y <= bottom);
+}
+
+template <typename Scalar>
+void BasicBoundingBox<Scalar>::moveBy(const BasicPosition<Scalar> &pos)
+{
+  left += pos._x;
+  right += pos._x;
+  top += pos._y;
+  bottom += pos._y;
+}
+
+template struct BasicBoundingBox<float>;
+template struct BasicBoundingBox<double>;
+
+template <typename T, int SIZE>
+static BasicBoundingBox<typename T::Scalar>
+getBoundingBoxOf(const ObjectPool<T, SIZE> &pool)
+{
+  using Scalar = typename T::Scalar;
+  // use static_assert until C++20 concepts are available
+  static_assert(std::is_base_of<BasicGameObject<Scalar>, T>::value,
+                "only supports pools of type GameObject");
+#if defined(CPP20)
+  // see comment above
+  static_assert(false);
+#endif
+
+  bool atLeastOneEnemyAlive = pool.any();
+
+  Scalar left{std::numeric_limits<Scalar>::max()};
+  Scalar top{std::numeric_limits<Scalar>::max()};
+  Scalar right{std::numeric_limits<Scalar>::min()};
+  Scalar bottom{std::numeric_limits<Scalar>::min()};
+  for (int i : pool.alive())
+  {
+    BasicPosition<Scalar> pos = pool[i].getPosition();
+    if (pos._x < left)
+      left = pos._x;
+    if (pos._y < top)
+      top = pos._y;
+    if (pos._x > right)
+      right = pos._x;
+    if (pos._y > bottom)
+      bottom = pos._y;
+  }
+
+  if (atLeastOneEnemyAlive)
+  {
+    // The origin position of a sprite is the middle, therefore the
+    // bounding box is expanded in all directions by half the sprite size
+    left -= Engine::SpriteSize / 2;
+    top -= Engine::SpriteSize / 2;
+    right += Engine::SpriteSize / 2;
+    bottom += Engine::SpriteSize / 2;
+
+    return {left, top, right, bottom};
+  }
+  else
+  {
+    return {};
+  }
+}
+
+template <typename Cfg, typename Pool, typename Object, typename Box>
+int ColumnCollision::findHit(const Pool &enemies, const Object &rocket,
+                             const Box &formation)
+{
+  using Scalar = typename Object::Scalar;
+
+  // Explanation:
+  // There are two bounding boxes, one (formation) that encloses all enemies,
+  // and another one only those that are alive. The caller uses the latter
+  // to verify if a rocket even hits the region of alive enemies. If that is
+  // the case, the formation is used to determine the column and an
+  // additional radius check is applied on all enemies from bottom to top.
+  // That results in a worst case complexity for the enemy lookup of
+  // Big-O(Cfg::ENEMY_ROWS)
+  BasicPosition<Scalar> rpos = rocket.getPosition();
+
+  // Calculate the rocket position in the original bounding box to
+  // calculate the column
+  int column = int(Scalar(rpos._x - formation.left) / Engine::SpriteSize);
+
+  // if outer range
+  if (unlikely(column > Cfg::ENEMY_COLS || column < 0))
+    return -1;
+  else if (unlikely(column ==
+                    Cfg::ENEMY_COLS)) // happens if rocket hits the right
+                                      // side of the bbox
+    column--;
+
+  // iterate through all enemies of that column from bottom to top
+  int end = column * Cfg::ENEMY_ROWS;
+  for (int i = (column + 1) * Cfg::ENEMY_ROWS - 1; i >= end; --i)
+  {
+    if (enemies.isAlive(i) && enemies[i].intersectsWith(rocket))
+      return i;
+  }
+  return -1;
+}
+
+template <typename Cfg, typename Pool, typename Object, typename Box>
+int BruteForceCollision::findHit(const Pool &enemies, const Object &rocket,
+                                 const Box &)
+{
+  for (int i = Pool::size() - 1; i >= 0; --i)
+  {
+    if (enemies.isAlive(i) && enemies[i].intersectsWith(rocket))
+      return i;
+  }
+  return -1;
+}
+
+void Highscore::finishScore()
+{
+  if (_currentScore > _oldHighscore)
+    _oldHighscore = _currentScore;
+  _currentScore = 0;
+}
+
+void Highscore::addScore() { _currentScore++; }
+
+int Highscore::getCurrentScore() const { return _currentScore; }
+
+int Highscore::getHighscore() const { return _oldHighscore; }
+
+void Highscore::writeToDisk() const
+{
+  // a buffer of its own, otherwise the stream allocates one at every game
+  // over
+  char buffer[64];
+  std::ofstream hscore;
+  hscore.rdbuf()->pubsetbuf(buffer, sizeof(buffer));
+  hscore.open("spaceinvaders.hscore");
+  // P.S. I tend to avoid using reinterpret_cast if possible due to its
+  // tendency to be very restrictive but since char* and byte casts are well
+  // defined this is safe
+  hscore.write(reinterpret_cast<const char *>(&_fileversion),
+               sizeof(_fileversion));
+  if (_currentScore > _oldHighscore)
+    hscore.write(reinterpret_cast<const char *>(&_currentScore),
+                 sizeof(_currentScore));
+  else
+    hscore.write(reinterpret_cast<const char *>(&_oldHighscore),
+                 sizeof(_oldHighscore));
+}
+
+void Highscore::readFromDisk()
+{
+  std::ifstream hscore{"spaceinvaders.hscore"};
+
+  int fileversion{0};
+  hscore.read(reinterpret_cast<char *>(&fileversion), sizeof(fileversion));
+  if (fileversion == 1)
+  {
+    hscore.read(reinterpret_cast<char *>(&_oldHighscore),
+                sizeof(_oldHighscore));
+  }
+}
+
+template <typename Cfg>
+const int GameSimulation<Cfg>::ROCKET_STEP;
+template <typename Cfg>
+const int GameSimulation<Cfg>::BOMB_SPEED;
+
+template <typename Cfg>
+GameSimulation<Cfg>::GameSimulation()
+    : _dis(0, Cfg::ENEMY_COUNT - 1)
+{
+  reset();
+}
+
+template <typename Cfg>
+void GameSimulation<Cfg>::start(double now)
+{
+  _timers.start(now);
+  _currentTimestamp = now;
+}
+
+template <typename Cfg>
+void GameSimulation<Cfg>::reset(RESET reset)
+{
+  if (reset == RESET::ALSO_PLAYER_POSITION)
+  {
+    initPlayer();
+  }
+
+  _player.setHealth(Cfg::PLAYER_HEALTH);
+  _gameOver = false;
+
+  initEnemies();
+  initRockets();
+  initBombs();
+}
+
+template <typename Cfg>
+void GameSimulation<Cfg>::advanceTime(double now)
+{
+  _currentTimestamp = now;
+  _timers.advance(now, [this](SIMTIMER timer) { onTimer(timer); });
+}
+
+template <typename Cfg>
+void GameSimulation<Cfg>::onTimer(SIMTIMER timer)
+{
+  switch (timer)
+  {
+  case SIMTIMER::SHOT_COOLDOWN:
+    _shotReady = true;
+    break;
+  case SIMTIMER::BOMB_COOLDOWN:
+    _bombReady = true;
+    break;
+  case SIMTIMER::COUNT:
+    break;
+  }
+}
+
+template <typename Cfg>
+void GameSimulation<Cfg>::movePlayer(const Engine::PlayerInput &keys,
+                                     double seconds)
+{
+  if (keys.left)
+  {
+    Position pos = _player.getPosition();
+    if (pos._x > 0)
+    {
+      _player.setPositionX(pos._x - 400 * seconds);
+    }
+  }
+
+  if (keys.right)
+  {
+    Position pos = _player.getPosition();
+    if (pos._x < Engine::CanvasWidth - Engine::SpriteSize)
+    {
+      _player.setPositionX(pos._x + 400 * seconds);
+    }
+  }
+}
+
+template <typename Cfg>
+void GameSimulation<Cfg>::fire(double timestamp)
+{
+  if (_shotReady) // restrict shooting per second
+  {
+    int i = _rockets.firstFree();
+    if (i >= 0)
+    {
+      _shotReady = false;
+      _timers.schedule(SIMTIMER::SHOT_COOLDOWN,
+                       timestamp + Cfg::TIME_BETWEEN_SHOTS);
+      _rockets.spawn(i, _player.getPosition());
+    }
+  }
+}
+
+template <typename Cfg>
+void GameSimulation<Cfg>::update(double now, double seconds)
+{
+  beginUpdate(now, seconds);
+  updateEnemies();
+  updateBombs();
+  updateRockets();
+}
+
+template <typename Cfg>
+void GameSimulation<Cfg>::beginUpdate(double now, double seconds)
+{
+  _currentTimestamp = now;
+  _msPerFrame = seconds;
+}
+
+template <typename Cfg>
+void GameSimulation<Cfg>::initPlayer()
+{
+  Scalar posX = Engine::CanvasWidth / 2;
+  Scalar posY = Engine::CanvasHeight - (Engine::SpriteSize / 2);
+  _player.setPosition({posX, posY});
+}
+
+template <typename Cfg>
+void GameSimulation<Cfg>::initEnemies()
+{
+  // the origin of the enemies is right below the top bar
+  int startY{Engine::FontRowHeight + 10};
+
+  for (int i = 0; i < EnemyPool::size(); ++i)
+  {
+    Scalar col = (i / Cfg::ENEMY_ROWS);
+    Scalar row = (i % Cfg::ENEMY_ROWS);
+    _enemies.spawn(
+        i, {col * Engine::SpriteSize + (Engine::SpriteSize / 2),
+            startY + row * Engine::SpriteSize + +(Engine::SpriteSize / 2)});
+  }
+
+  _enemyBbox = getBoundingBoxOf(_enemies);
+  _enemyBboxOriginal = _enemyBbox;
+}
+
+template <typename Cfg>
+void GameSimulation<Cfg>::initRockets() { _rockets.destroyAll(); }
+
+template <typename Cfg>
+void GameSimulation<Cfg>::initBombs() { _bombs.destroyAll(); }
+
+template <typename Cfg>
+void GameSimulation<Cfg>::updateRockets()
+{
+  // delete rockets which are out of
+  for (int i : _rockets.alive())
+  {
+    Position pos = _rockets[i].getPosition();
+
+    // make rocket travel on y-axis and
+    // destroy rocket until it left canvas
+    if (pos._y > -Engine::SpriteSize)
+    {
+      _rockets[i].setPositionY(pos._y - ROCKET_STEP);
+    }
+    else
+    {
+      _rockets.destroy(i);
+    }
+  }
+}
+
+template <typename Cfg>
+void GameSimulation<Cfg>::updateBombs()
+{
+  // Bombs used to be dropped in the same loop that moved them, slot by slot.
+  // The drops go to the slots that were free before the loop, so a slot
+  // freed in this update is not reused before the next one, and a fatal hit
+  // ends the update after the drops into the free slots below it.
+  const std::uint64_t free = _bombs.freeMask();
+  for (int i : _bombs.alive())
+  {
+    Bomb &b = _bombs[i];
+    Position pos = b.getPosition();
+    // if aliens are out of screen
+    if (pos._y > Engine::CanvasHeight)
+    {
+      _bombs.destroy(i);
+    }
+    else if (b.intersectsWith(_player))
+    {
+      _bombs.destroy(i);
+      _player.hit();
+      if (!_player.isAlive())
+      {
+        _gameOver = true;
+        dropBombs(free & ((std::uint64_t{1} << i) - 1));
+        return;
+      }
+    }
+    else
+    {
+      b.setPositionY(pos._y + BOMB_SPEED * _msPerFrame);
+    }
+  }
+
+  dropBombs(free);
+}
+
+template <typename Cfg>
+void GameSimulation<Cfg>::dropBombs(std::uint64_t slots)
+{
+  // case to drop bombs, which are restricted to drop by time
+  for (int i : AliveIndices{slots})
+  {
+    if (!_bombReady)
+      break;
+
+    // a random enemy drops the bomb if it is still alive
+    int index = _dis(_rd);
+    if (_enemies.isAlive(index))
+    {
+      _bombReady = false;
+      _timers.schedule(SIMTIMER::BOMB_COOLDOWN,
+                       _currentTimestamp + Cfg::TIME_BETWEEN_BOMBS);
+      _bombs.spawn(i, _enemies[index].getPosition());
+    }
+  }
+}
+
+template <typename Cfg>
+void GameSimulation<Cfg>::updateEnemies()
+{
+  if (_enemyBbox.bottom >= Engine::CanvasHeight)
+  {
+    // If an alien reaches the bottom of the screen, the player loses and the
+    // game is over.
+    _gameOver = true;
+    return;
+  }
+  else if (_enemyBbox.intersectsWith(_player))
+  {
+    for (int i : _enemies.alive())
+    {
+      if (_enemies[i].intersectsWith(_player))
+      {
+        // If the alien collides with the player, the alien
+        // is destroyed and the player's health is decreased.
+        _enemies.destroy(i);
+        _player.hit();
+
+        if (!_player.isAlive())
+        {
+          _gameOver = true;
+          return;
+        }
+        break;
+      }
+    }
+  }
+
+  // destroy an enemy if it got hit by a rocket
+  bool enemyDied{false};
+  for (int ri : _rockets.alive())
+  {
+    Rocket &r = _rockets[ri];
+
+    // check if rocket intersects
+    // with the bounding box of the enemies
+    if (!_enemyBbox.intersectsWith(r))
+      continue;
+
+    int i = Cfg::Collision::template findHit<Cfg>(_enemies, r,
+                                                  _enemyBboxOriginal);
+    if (i >= 0)
+    {
+      _rockets.destroy(ri);
+      _enemies.destroy(i);
+
+      enemyDied = true;
+      _hscore.addScore();
+    }
+  }
+
+  if (enemyDied)
+  {
+    if (!_enemies.any())
+    {
+      // if all enemies are destroyed,
+      // reset all of them and start over
+      initEnemies();
+      ++_level;
+    }
+    else
+    {
+      // update bounding box if at least one enemy died
+      _enemyBbox = getBoundingBoxOf(_enemies);
+    }
+  }
+
+  // move all enemies in travel direction
+  Scalar travelStepX{0};
+  Scalar travelStepY{0};
+  if (_enemy_direction == ENEMY_DIRECTION::RIGHT)
+  {
+    if (_enemyBbox.right < Engine::CanvasWidth)
+    {
+      travelStepX = 200 * _msPerFrame;
+    }
+    else
+    {
+      travelStepY = 10 * _level; // down step is dependend on level
+      _enemy_direction = ENEMY_DIRECTION::LEFT;
+      travelStepX = -1;
+    }
+  }
+  else // _enemy_direction == ENEMY_DIRECTION::RIGHT
+  {
+    if (_enemyBbox.left > 0)
+    {
+      travelStepX = -(200 * _msPerFrame);
+    }
+    else
+    {
+      travelStepY = 10 * _level; // down step is dependend on level
+      _enemy_direction = ENEMY_DIRECTION::RIGHT;
+      travelStepX = 1;
+    }
+  }
+
+  // destroyed enemies are respawned by initEnemies, so only the alive ones
+  // need to travel
+  for (int i : _enemies.alive())
+  {
+    Enemy &e = _enemies[i];
+    e.setPositionX(e.getPosition()._x + travelStepX);
+    e.setPositionY(e.getPosition()._y + travelStepY);
+  }
+
+  _enemyBbox.moveBy({travelStepX, travelStepY});
+  _enemyBboxOriginal.moveBy({travelStepX, travelStepY});
+}
+
+template class GameSimulation<Config>;
+template class GameSimulation<HeadlessConfig>;
+template class GameSimulation<StressConfig>;
+template class GameSimulation<RuntimeConfig>;
+template class GameSimulation<DoubleConfig>;
+template class GameSimulation<BruteForceConfig>;
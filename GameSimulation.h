@@ -0,0 +1,280 @@
+#ifndef GAME_SIMULATION_H__
+#define GAME_SIMULATION_H__
+
+#include <random>
+
+#include "Config.h"
+#include "Engine.h"
+#include "GameObjects.h"
+#include "TimerWheel.h"
+
+/// State of the game at any given time.
+enum class GAMESTATE : int
+{
+  WELCOME,
+  WELCOME_3,
+  WELCOME_2,
+  WELCOME_1,
+  GO,
+  PLAY,
+  GAMEOVER,
+  TRYAGAIN
+};
+
+/// Flag used when scene is resetted.
+enum class RESET : int
+{
+  BUT_NOT_THE_PLAYER,
+  ALSO_PLAYER_POSITION,
+};
+
+/// The travel direction of all enemies.
+enum class ENEMY_DIRECTION : int
+{
+  LEFT,
+  RIGHT
+};
+
+/// Cooldowns of the simulation, see GameSimulation::onTimer.
+enum class SIMTIMER : int
+{
+  SHOT_COOLDOWN,
+  BOMB_COOLDOWN,
+  COUNT
+};
+
+/// Bounding box with absolute integer values.
+template <typename Scalar>
+struct BasicBoundingBox
+{
+  Scalar left{0};
+  Scalar top{0};
+  Scalar right{0};
+  Scalar bottom{0};
+
+  /// Checks if a game object position is in a bounding box.
+  /// @param o Game object to check.
+  bool intersectsWith(const BasicGameObject<Scalar>& o) const;
+
+  /// Move the bounding box towards a given position.
+  /// @param pos The position to move the bounding box. Can be negative or
+  /// positive.
+  void moveBy(const BasicPosition<Scalar>& pos);
+};
+
+using BoundingBox = BasicBoundingBox<float>;
+
+/// Collision policy of the game (Config::Collision): a rocket inside the
+/// bounding box of the alive enemies is mapped to its column in the
+/// original formation, only the enemies of that column are checked, from
+/// bottom to top. O(Cfg::ENEMY_ROWS) per rocket.
+struct ColumnCollision
+{
+  /// Returns the index of the enemy the rocket hits, or -1.
+  /// @param formation Bounding box of the formation with all enemies.
+  template <typename Cfg, typename Pool, typename Object, typename Box>
+  static int findHit(const Pool &enemies, const Object &rocket,
+                     const Box &formation);
+};
+
+/// Collision policy that checks every alive enemy, from the highest index
+/// down. O(Cfg::ENEMY_COUNT) per rocket, for comparison with
+/// ColumnCollision.
+struct BruteForceCollision
+{
+  /// Returns the index of the enemy the rocket hits, or -1.
+  template <typename Cfg, typename Pool, typename Object, typename Box>
+  static int findHit(const Pool &enemies, const Object &rocket,
+                     const Box &formation);
+};
+
+/// High score object that handles points. It can read and write the highscore
+/// from and to disk.
+class Highscore
+{
+public:
+  /// Adds a point to the score list.
+  void addScore();
+
+  /// Finishs a round. Does not write the score to disk, must be called
+  /// explicitly.
+  void finishScore();
+
+  /// Gets the absolute highscore of all games.
+  int getHighscore() const;
+
+  /// Gets the score of the current game.
+  int getCurrentScore() const;
+
+  /// Writes the highest score (depending if the current, or previous highscore
+  /// is higher) to disk. The file the score is written to is
+  /// "spaceinvaders.hscore".
+  void writeToDisk() const;
+
+  /// Reads the highscore from the file "spaceinvaders.hscore" if it exists.
+  void readFromDisk();
+
+public:
+  int _fileversion{1};
+  int _currentScore{0};
+  int _oldHighscore{0};
+};
+
+/// The rules of the game while it is played: the scene objects, the score
+/// and the cooldowns, without any drawing, input or game state handling.
+/// It is plain data, a copy continues exactly like the original, e.g. to
+/// look ahead what an input would lead to.
+template <typename Cfg = Config>
+class GameSimulation
+{
+public:
+  using Scalar = typename Cfg::Scalar;
+  using Position = BasicPosition<Scalar>;
+  using BoundingBox = BasicBoundingBox<Scalar>;
+  using Enemy = BasicEnemy<Scalar>;
+  using Bomb = BasicBomb<Scalar>;
+  using Rocket = BasicRocket<Scalar>;
+  using Player = BasicPlayer<Scalar>;
+  using EnemyPool = ObjectPool<Enemy, Cfg::ENEMY_COUNT>;
+  using BombPool = ObjectPool<Bomb, Cfg::MAX_BOMB_COUNT>;
+  using RocketPool = ObjectPool<Rocket, Cfg::MAX_ROCKET_COUNT>;
+
+  /// Pixels a rocket travels up per update.
+  static const int ROCKET_STEP{1};
+  /// Pixels a bomb falls per second.
+  static const int BOMB_SPEED{150};
+
+  GameSimulation();
+
+  /// Sets the time the cooldowns are measured from.
+  void start(double now);
+
+  /// Resets the scene. Is used for instance on startup, or to restart the
+  /// game after game is lost.
+  /// @param reset		Used to reset entire scene. Player position can be
+  /// excluded with corresponding flag
+  void reset(RESET reset = RESET::ALSO_PLAYER_POSITION);
+
+  /// Expires the cooldowns that passed until now.
+  void advanceTime(double now);
+
+  /// Moves the player according to the held keys.
+  /// @param seconds Time since the last move.
+  void movePlayer(const Engine::PlayerInput &keys, double seconds);
+
+  /// Shoots a rocket if the cooldown and the rocket pool allow it.
+  /// @param timestamp Time the fire key was pressed.
+  void fire(double timestamp);
+
+  /// Moves enemies, bombs and rockets and resolves their hits. Runs
+  /// beginUpdate and the update phases below, which are public so they can
+  /// be timed separately (see StressTest).
+  /// @param now Current time.
+  /// @param seconds Time since the last update.
+  void update(double now, double seconds);
+
+  /// One tick of play as the game runs it: time, a fire key press, movement
+  /// and the update. Rockets start where the player was before moving, like
+  /// in BasicGameEngine::handleEvents.
+  void tick(const Engine::PlayerInput &keys, bool firePressed, double now,
+            double seconds)
+  {
+    advanceTime(now);
+    if (firePressed)
+      fire(now);
+    movePlayer(keys, seconds);
+    update(now, seconds);
+  }
+
+  /// Seeds the random generator of the bomb drops.
+  void seed(unsigned seed) { _rd.seed(seed); }
+
+  /// Sets the time for the following update phases.
+  /// @param now Current time.
+  /// @param seconds Time since the last update.
+  void beginUpdate(double now, double seconds);
+
+  /// Takes actions on enemies. Resets enemies if they left the canvas
+  /// (according to the bounding box). Also removes health from player if  the
+  /// player if an enemy hit the player. Also destroys an enemy, if it got hit
+  /// by a rocket.
+  void updateEnemies();
+  /// Takes actions on bombs. Destroys them if they left the canvas. Subtracts
+  /// health point from player if hit. Also sends bombs from enemies in a
+  /// n-interval towards y axis.
+  void updateBombs();
+  /// Lets random enemies drop a bomb into the given free slots, in order,
+  /// until one dropped or the cooldown is not over.
+  void dropBombs(std::uint64_t slots);
+  /// Takes actions on rockets. Sends them in travel direction. Also destroys
+  /// them if they left the canvas.
+  void updateRockets();
+
+  /// True once the player died or the enemies reached the bottom, until the
+  /// next reset.
+  bool isGameOver() const { return _gameOver; }
+
+  const Player &getPlayer() const { return _player; }
+  const EnemyPool &getEnemies() const { return _enemies; }
+  const RocketPool &getRockets() const { return _rockets; }
+  const BombPool &getBombs() const { return _bombs; }
+  int getLevel() const { return _level; }
+  Highscore &getHighscore() { return _hscore; }
+  const Highscore &getHighscore() const { return _hscore; }
+
+private:
+  /// Reacts to an expired cooldown.
+  void onTimer(SIMTIMER timer);
+
+  /// Initializes the players position. Does not set the health.
+  void initPlayer();
+  /// Sets the position and health of all enemies.
+  void initEnemies();
+  /// Resets all rocket objects and sets them to non-alive.
+  void initRockets();
+  /// Resets all bombs and sets them to non-alive.
+  void initBombs();
+
+  /// Level info, travel direction of enemies and score
+  ENEMY_DIRECTION _enemy_direction{ENEMY_DIRECTION::RIGHT};
+  Highscore _hscore;
+  int _level{1};
+  bool _gameOver{false};
+
+  /// Time of the current update
+  double _currentTimestamp{0.0};
+  double _msPerFrame{0.0};
+
+  /// Deadlines of the cooldowns. The flags are set when the corresponding
+  /// timer expires.
+  TimerWheel<SIMTIMER, static_cast<int>(SIMTIMER::COUNT)> _timers;
+  bool _shotReady{true};
+  bool _bombReady{true};
+
+  /// Scene objects + bounding box of enemies
+  Player _player;
+  RocketPool _rockets;
+  BombPool _bombs;
+  EnemyPool _enemies;
+
+  /// Bounding box encloses only aliens that are alive.
+  BoundingBox _enemyBbox;
+
+  /// Original bounding box used to determine where rocket hits which column.
+  /// Does enclose all aliens, no matter if destroyed or not
+  BoundingBox _enemyBboxOriginal;
+
+  /// Random generator for index of enemies dropping bombs
+  std::default_random_engine _rd;
+  std::uniform_int_distribution<int> _dis;
+};
+
+// defined and instantiated in GameSimulation.cpp
+extern template class GameSimulation<Config>;
+extern template class GameSimulation<HeadlessConfig>;
+extern template class GameSimulation<StressConfig>;
+extern template class GameSimulation<RuntimeConfig>;
+extern template class GameSimulation<DoubleConfig>;
+extern template class GameSimulation<BruteForceConfig>;
+
+#endif // GAME_SIMULATION_H__
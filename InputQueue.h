@@ -0,0 +1,94 @@
+#ifndef INPUT_QUEUE_H__
+#define INPUT_QUEUE_H__
+
+#include <atomic>
+#include <cstdint>
+
+#include "Engine.h"
+#include "SpscRing.h"
+
+/// Keys the game reacts to.
+enum class INPUT_KEY : std::uint8_t
+{
+  LEFT,
+  RIGHT,
+  FIRE
+};
+
+/// Producer of the events of an InputQueue.
+enum class INPUT_SOURCE : std::uint8_t
+{
+  SNAPSHOTS, // polled key states, turned into events on the game thread
+  EVENTS     // key events pushed by a backend, possibly from its own thread
+};
+
+/// A key was pressed or released at the given stopwatch time.
+struct InputEvent
+{
+  double timestamp{0.0};
+  INPUT_KEY key{INPUT_KEY::FIRE};
+  bool pressed{false};
+};
+
+/// Queue of timestamped key events. The game loop processes all of them in
+/// order once per frame, so presses shorter than a frame still reach the
+/// game.
+///
+/// The ring has room for one producer only, the source decides which one it
+/// is. By default the game loop turns polled key states into events with
+/// pushSnapshot. After useBackendEvents, only a backend pushes its events,
+/// possibly from its own thread, and snapshots are ignored.
+class InputQueue
+{
+public:
+  /// Game loop only, before the backend pushes its first event.
+  void useBackendEvents() { _source = INPUT_SOURCE::EVENTS; }
+
+  INPUT_SOURCE getSource() const { return _source; }
+
+  /// Backend only, after useBackendEvents. Returns false if the queue takes
+  /// snapshots, or if it is full, which is counted.
+  bool push(const InputEvent &event)
+  {
+    if (_source != INPUT_SOURCE::EVENTS)
+      return false;
+    return enqueue(event);
+  }
+
+  /// Game loop only. Returns false if there are no more events.
+  bool pop(InputEvent &event) { return _events.pop(event); }
+
+  /// Game loop only, for backends that can only be polled: pushes an event
+  /// for every key that changed since the previous snapshot. Does nothing
+  /// after useBackendEvents.
+  void pushSnapshot(const Engine::PlayerInput &keys, double timestamp)
+  {
+    if (_source != INPUT_SOURCE::SNAPSHOTS)
+      return;
+    if (keys.left != _snapshot.left)
+      enqueue({timestamp, INPUT_KEY::LEFT, keys.left});
+    if (keys.right != _snapshot.right)
+      enqueue({timestamp, INPUT_KEY::RIGHT, keys.right});
+    if (keys.fire != _snapshot.fire)
+      enqueue({timestamp, INPUT_KEY::FIRE, keys.fire});
+    _snapshot = keys;
+  }
+
+  int getDroppedEvents() const { return _droppedEvents; }
+
+private:
+  bool enqueue(const InputEvent &event)
+  {
+    if (_events.push(event))
+      return true;
+    ++_droppedEvents;
+    return false;
+  }
+
+  INPUT_SOURCE _source{INPUT_SOURCE::SNAPSHOTS};
+  SpscRing<InputEvent, 256> _events;
+  Engine::PlayerInput _snapshot{};
+  std::atomic<int> _droppedEvents{0};
+};
+
+#endif // INPUT_QUEUE_H__
@@ -0,0 +1,56 @@
+#ifndef LATENCY_STATS_H__
+#define LATENCY_STATS_H__
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+/// Keeps the most recent latency samples and reports their percentiles.
+class LatencyStats
+{
+public:
+  static const int SAMPLE_COUNT{1024};
+
+  struct Percentiles
+  {
+    double p50{0.0};
+    double p99{0.0};
+  };
+
+  /// Adds a sample in seconds, replacing the oldest one if full.
+  void addSample(double seconds)
+  {
+    _samples[_next] = seconds;
+    _next = (_next + 1) % SAMPLE_COUNT;
+    if (_count < SAMPLE_COUNT)
+      ++_count;
+  }
+
+  int getSampleCount() const { return _count; }
+
+  /// Percentiles of the kept samples in seconds, 0 if there are none.
+  Percentiles getPercentiles() const
+  {
+    if (_count == 0)
+      return {};
+
+    // full size at once, so the buffer isn't regrown while samples come in
+    _sorted.reserve(SAMPLE_COUNT);
+    _sorted.assign(_samples.begin(), _samples.begin() + _count);
+    auto at = [this](double percentile) {
+      auto it = _sorted.begin() + static_cast<int>(percentile * (_count - 1));
+      std::nth_element(_sorted.begin(), it, _sorted.end());
+      return *it;
+    };
+    return {at(0.5), at(0.99)};
+  }
+
+private:
+  std::array<double, SAMPLE_COUNT> _samples{};
+  int _next{0};
+  int _count{0};
+  // scratch buffer of getPercentiles
+  mutable std::vector<double> _sorted;
+};
+
+#endif // LATENCY_STATS_H__
@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <cmath>
+
+#include "LookaheadBot.h"
+
+template <typename Cfg>
+const int LookaheadBot<Cfg>::SEGMENTS;
+template <typename Cfg>
+const int LookaheadBot<Cfg>::TICKS_PER_SEGMENT;
+
+template <typename Cfg>
+LookaheadBot<Cfg>::LookaheadBot(int threads, MetricsRegistry &metrics)
+    : _metrics(metrics), _actions(Cfg::BOT_CANDIDATES * SEGMENTS),
+      _clones(Cfg::BOT_CANDIDATES), _seeds(Cfg::BOT_CANDIDATES),
+      _results(Cfg::BOT_CANDIDATES)
+{
+  for (int i = 1; i < threads; ++i)
+    _workers.emplace_back([this] { workerLoop(); });
+}
+
+template <typename Cfg>
+LookaheadBot<Cfg>::~LookaheadBot()
+{
+  {
+    std::lock_guard<std::mutex> lock{_mutex};
+    _quit = true;
+  }
+  _wake.notify_all();
+  for (std::thread &worker : _workers)
+    worker.join();
+}
+
+template <typename Cfg>
+Engine::PlayerInput LookaheadBot<Cfg>::keysOf(ACTION action)
+{
+  switch (action)
+  {
+  case ACTION::LEFT:
+    return {true, false, false};
+  case ACTION::RIGHT:
+    return {false, true, false};
+  case ACTION::STAY_FIRING:
+    return {false, false, true};
+  case ACTION::LEFT_FIRING:
+    return {true, false, true};
+  case ACTION::RIGHT_FIRING:
+    return {false, true, true};
+  case ACTION::STAY:
+  case ACTION::COUNT:
+  default:
+    return {false, false, false};
+  }
+}
+
+template <typename Cfg>
+Engine::PlayerInput
+LookaheadBot<Cfg>::decide(const GameSimulation<Cfg> &sim, double now,
+                          const Engine::PlayerInput &held)
+{
+  ScopedMetricTimer timer{_metrics, METRIC::BOT_DECISION_SECONDS};
+
+  // every action is tried in the first segment, the later ones are random
+  const int actionCount{static_cast<int>(ACTION::COUNT)};
+  std::uniform_int_distribution<int> randomAction{0, actionCount - 1};
+  for (int c = 0; c < Cfg::BOT_CANDIDATES; ++c)
+  {
+    _actions[c * SEGMENTS] = static_cast<ACTION>(c % actionCount);
+    for (int s = 1; s < SEGMENTS; ++s)
+      _actions[c * SEGMENTS + s] = static_cast<ACTION>(randomAction(_rd));
+    _seeds[c] = static_cast<unsigned>(_rd());
+  }
+
+  _source = &sim;
+  _now = now;
+  _fireHeld = held.fire;
+  _nextCandidate.store(0, std::memory_order_relaxed);
+  {
+    std::lock_guard<std::mutex> lock{_mutex};
+    ++_generation;
+    _pending = static_cast<int>(_workers.size());
+  }
+  _wake.notify_all();
+
+  runCandidates();
+
+  {
+    std::unique_lock<std::mutex> lock{_mutex};
+    _done.wait(lock, [this] { return _pending == 0; });
+  }
+
+  // ties go to the lower candidate, so the choice is deterministic
+  int best{0};
+  for (int c = 1; c < Cfg::BOT_CANDIDATES; ++c)
+  {
+    if (_results[c].value > _results[best].value)
+      best = c;
+  }
+  _metrics.add(METRIC::BOT_DECISIONS);
+
+  Engine::PlayerInput keys = keysOf(_actions[best * SEGMENTS]);
+  keys.fire = keys.fire && !held.fire;
+  return keys;
+}
+
+template <typename Cfg>
+void LookaheadBot<Cfg>::runCandidates()
+{
+  std::int64_t ticks{0};
+  for (int c = _nextCandidate.fetch_add(1, std::memory_order_relaxed);
+       c < Cfg::BOT_CANDIDATES;
+       c = _nextCandidate.fetch_add(1, std::memory_order_relaxed))
+  {
+    _results[c].value = evaluate(c, ticks);
+  }
+  _metrics.add(METRIC::BOT_SIMULATED_TICKS, ticks);
+}
+
+template <typename Cfg>
+std::int64_t LookaheadBot<Cfg>::evaluate(int candidate, std::int64_t &ticks)
+{
+  GameSimulation<Cfg> &sim = _clones[candidate];
+  sim = *_source;
+  // the copy would replay the bomb drops of the game, the clone samples its
+  // own instead
+  sim.seed(_seeds[candidate]);
+  const int scoreBefore = sim.getHighscore().getCurrentScore();
+  const ACTION *actions = &_actions[candidate * SEGMENTS];
+
+  bool fireHeld{_fireHeld};
+  int tick{0};
+  for (; tick < Cfg::BOT_LOOKAHEAD_TICKS && !sim.isGameOver(); ++tick)
+  {
+    Engine::PlayerInput keys = keysOf(actions[tick / TICKS_PER_SEGMENT]);
+    // firing candidates tap the key, it has to go up between two shots
+    keys.fire = keys.fire && !fireHeld;
+    fireHeld = keys.fire;
+    sim.tick(keys, keys.fire, _now + tick * Cfg::BOT_TICK_SECONDS,
+             Cfg::BOT_TICK_SECONDS);
+  }
+  ticks += tick;
+
+  // Survival counts most, then health and score. Among equal outcomes the
+  // player should stay below the enemies, where the next shots can hit.
+  const int scored = sim.getHighscore().getCurrentScore() - scoreBefore;
+  const int health = sim.isGameOver() ? 0 : sim.getPlayer().getHealth();
+  float distance{0};
+  const auto &enemies = sim.getEnemies();
+  if (enemies.any())
+  {
+    float left{static_cast<float>(Engine::CanvasWidth)};
+    float right{0};
+    for (int i : enemies.alive())
+    {
+      left = std::min(left, enemies[i].getPosition()._x);
+      right = std::max(right, enemies[i].getPosition()._x);
+    }
+    distance = std::abs((left + right) / 2 - sim.getPlayer().getPosition()._x);
+  }
+
+  return static_cast<std::int64_t>(tick) * 100000000 + health * 1000000 +
+         scored * 1000 +
+         (Engine::CanvasWidth - std::min(static_cast<int>(distance),
+                                         Engine::CanvasWidth - 1));
+}
+
+template <typename Cfg>
+void LookaheadBot<Cfg>::workerLoop()
+{
+  int generation{0};
+  for (;;)
+  {
+    {
+      std::unique_lock<std::mutex> lock{_mutex};
+      _wake.wait(lock,
+                 [&] { return _quit || _generation != generation; });
+      if (_quit)
+        return;
+      generation = _generation;
+    }
+
+    runCandidates();
+
+    {
+      std::lock_guard<std::mutex> lock{_mutex};
+      if (--_pending == 0)
+        _done.notify_one();
+    }
+  }
+}
+
+template class LookaheadBot<Config>;
+template class LookaheadBot<HeadlessConfig>;
@@ -0,0 +1,116 @@
+#ifndef LOOKAHEAD_BOT_H__
+#define LOOKAHEAD_BOT_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "Config.h"
+#include "Engine.h"
+#include "GameSimulation.h"
+#include "Metrics.h"
+
+/// Plays the game by looking ahead. Every decision copies the simulation
+/// once per candidate input sequence, plays each copy Cfg::BOT_LOOKAHEAD_TICKS
+/// ahead and holds the first input of the candidate that survives longest
+/// and scores most. Every copy is reseeded, so the bomb drops ahead are
+/// sampled rather than replayed from the game. The candidates are spread
+/// over a pool of threads.
+///
+/// Besides playing, it is a load generator and a benchmark of the
+/// simulation: decisions, the time spent on them and the ticks played ahead
+/// are counted in the metrics.
+template <typename Cfg = Config>
+class LookaheadBot
+{
+public:
+  /// @param threads Threads playing candidates, including the calling one.
+  /// @param metrics Receives the BOT_* counters.
+  LookaheadBot(int threads, MetricsRegistry &metrics);
+  ~LookaheadBot();
+
+  LookaheadBot(const LookaheadBot &) = delete;
+  LookaheadBot &operator=(const LookaheadBot &) = delete;
+
+  /// Chooses the keys of the next tick.
+  /// @param sim State of the game, is only read.
+  /// @param now Current time.
+  /// @param held Keys held in the last tick, the fire key shoots when it
+  /// goes down.
+  Engine::PlayerInput decide(const GameSimulation<Cfg> &sim, double now,
+                             const Engine::PlayerInput &held);
+
+  int getThreadCount() const { return static_cast<int>(_workers.size()) + 1; }
+
+private:
+  /// Inputs a candidate holds, one per segment of the lookahead.
+  enum class ACTION : std::uint8_t
+  {
+    STAY,
+    LEFT,
+    RIGHT,
+    STAY_FIRING,
+    LEFT_FIRING,
+    RIGHT_FIRING,
+    COUNT
+  };
+
+  static const int SEGMENTS{4};
+  static const int TICKS_PER_SEGMENT{
+      (Cfg::BOT_LOOKAHEAD_TICKS + SEGMENTS - 1) / SEGMENTS};
+
+  /// Outcome of a candidate, padded to its own cache line as every thread
+  /// writes different ones.
+  struct Result
+  {
+    std::int64_t value;
+    char padding[64 - sizeof(std::int64_t)];
+  };
+
+  static Engine::PlayerInput keysOf(ACTION action);
+
+  /// Plays candidates until none are left.
+  void runCandidates();
+  /// Plays one candidate ahead and rates it.
+  std::int64_t evaluate(int candidate, std::int64_t &ticks);
+
+  void workerLoop();
+
+  MetricsRegistry &_metrics;
+
+  /// Input of the current decision
+  const GameSimulation<Cfg> *_source{nullptr};
+  double _now{0.0};
+  bool _fireHeld{false};
+
+  /// Actions of all candidates, SEGMENTS per candidate
+  std::vector<ACTION> _actions;
+  /// Copies of the simulation, one per candidate
+  std::vector<GameSimulation<Cfg>> _clones;
+  /// Seeds of the bomb drops of the clones, drawn anew for every decision
+  std::vector<unsigned> _seeds;
+  std::vector<Result> _results;
+  std::atomic<int> _nextCandidate{0};
+
+  /// Picks the actions after the first segment and the seeds of the clones
+  std::default_random_engine _rd;
+
+  /// The workers wait for a new generation, the caller until none is pending
+  std::vector<std::thread> _workers;
+  std::mutex _mutex;
+  std::condition_variable _wake;
+  std::condition_variable _done;
+  int _generation{0};
+  int _pending{0};
+  bool _quit{false};
+};
+
+// defined and instantiated in LookaheadBot.cpp
+extern template class LookaheadBot<Config>;
+extern template class LookaheadBot<HeadlessConfig>;
+
+#endif // LOOKAHEAD_BOT_H__
@@ -0,0 +1,244 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#define METRICS_UNIX_SOCKET
+#endif
+
+// a stream socket whose reader went away raises SIGPIPE on a write, which
+// ends the game by default
+#if defined(MSG_NOSIGNAL)
+#define METRICS_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define METRICS_SEND_FLAGS 0
+#endif
+
+#include "Metrics.h"
+
+const int MetricsRegistry::MAX_THREADS;
+const int MetricsRegistry::METRIC_COUNT;
+const int MetricsRegistry::SHARED_SLOT;
+
+struct MetricInfo
+{
+  const char *name;
+  const char *help;
+  bool counter;
+  // factor from the stored integer to the exported value, 1 for values that
+  // are exported as integers
+  double scale;
+};
+
+static const double NANOSECONDS{1e-9};
+static const double MICROSECONDS{1e-6};
+
+// same order as METRIC
+static const MetricInfo METRIC_INFOS[] = {
+    {"spaceinvaders_frames_total", "Frames drawn.", true, 1.0},
+    {"spaceinvaders_frame_seconds_total", "Time spent in frames.", true,
+     NANOSECONDS},
+    {"spaceinvaders_hitches_total", "Frames that took longer than allowed.",
+     true, 1.0},
+    {"spaceinvaders_handle_events_seconds_total",
+     "Time spent handling input and timers.", true, NANOSECONDS},
+    {"spaceinvaders_update_seconds_total", "Time spent updating the scene.",
+     true, NANOSECONDS},
+    {"spaceinvaders_draw_seconds_total", "Time spent drawing the scene.", true,
+     NANOSECONDS},
+    {"spaceinvaders_enemies_alive", "Enemies alive.", false, 1.0},
+    {"spaceinvaders_rockets_in_use", "Occupied slots of the rocket pool.",
+     false, 1.0},
+    {"spaceinvaders_bombs_in_use", "Occupied slots of the bomb pool.", false,
+     1.0},
+    {"spaceinvaders_frame_arena_high_water_bytes",
+     "Most bytes allocated from the frame arena in one frame.", false, 1.0},
+    {"spaceinvaders_input_latency_p50_seconds",
+     "Median time from handling a key event to the end of its frame's draw.",
+     false, MICROSECONDS},
+    {"spaceinvaders_input_latency_p99_seconds",
+     "99th percentile of the time from handling a key event to the end of "
+     "its frame's draw.",
+     false, MICROSECONDS},
+    {"spaceinvaders_level", "Current level.", false, 1.0},
+    {"spaceinvaders_score", "Score of the current game.", false, 1.0},
+    {"spaceinvaders_highscore", "Highest score of all games.", false, 1.0},
+    {"spaceinvaders_bot_decisions_total", "Inputs chosen by the bot.", true,
+     1.0},
+    {"spaceinvaders_bot_decision_seconds_total",
+     "Time spent choosing inputs by the bot.", true, NANOSECONDS},
+    {"spaceinvaders_bot_simulated_ticks_total",
+     "Ticks played ahead by the bot.", true, 1.0},
+    {"spaceinvaders_spectator_messages_total",
+     "Messages sent to the spectator viewer.", true, 1.0},
+    {"spaceinvaders_spectator_bytes_total",
+     "Bytes sent to the spectator viewer.", true, 1.0},
+    {"spaceinvaders_spectator_dropped_messages_total",
+     "Messages the spectator viewer did not take.", true, 1.0},
+    {"spaceinvaders_spectator_seconds_total",
+     "Time spent encoding and sending spectator messages.", true,
+     NANOSECONDS},
+    {"spaceinvaders_captured_frames_total",
+     "Frames handed to the capture writer.", true, 1.0},
+    {"spaceinvaders_capture_dropped_frames_total",
+     "Frames not captured because the writer fell behind.", true, 1.0},
+    {"spaceinvaders_atlas_build_seconds",
+     "Time the software renderer spent filling its atlas and rasterizing "
+     "texts.",
+     false, NANOSECONDS},
+};
+
+static_assert(sizeof(METRIC_INFOS) / sizeof(METRIC_INFOS[0]) ==
+                  static_cast<size_t>(METRIC::COUNT),
+              "every METRIC needs an info entry");
+
+static std::atomic<int> nextThreadSlot{0};
+
+MetricsRegistry::~MetricsRegistry() { stopExporter(); }
+
+int MetricsRegistry::threadSlot()
+{
+  thread_local int slot = std::min(
+      nextThreadSlot.fetch_add(1, std::memory_order_relaxed), SHARED_SLOT);
+  return slot;
+}
+
+std::int64_t MetricsRegistry::get(METRIC metric) const
+{
+  const int index = static_cast<int>(metric);
+  if (!METRIC_INFOS[index].counter)
+    return _gauges[index].load(std::memory_order_relaxed);
+
+  std::int64_t sum{0};
+  for (const ThreadValues &thread : _threads)
+    sum += thread.values[index].load(std::memory_order_relaxed);
+  return sum;
+}
+
+std::string MetricsRegistry::exportText() const
+{
+  std::string text;
+  appendText(text);
+  return text;
+}
+
+void MetricsRegistry::appendText(std::string &text) const
+{
+  char value[32];
+  for (int i = 0; i < METRIC_COUNT; ++i)
+  {
+    const MetricInfo &info = METRIC_INFOS[i];
+    const std::int64_t raw = get(static_cast<METRIC>(i));
+    // counts stay exact, a double only has 53 bits. Scaled values get 17
+    // significant digits, enough to read back the same double.
+    if (info.scale == 1.0)
+      snprintf(value, sizeof(value), "%lld", static_cast<long long>(raw));
+    else
+      snprintf(value, sizeof(value), "%.17g", raw * info.scale);
+
+    text.append("# HELP ").append(info.name).append(" ").append(info.help);
+    text.append("\n# TYPE ").append(info.name).append(" ");
+    text.append(info.counter ? "counter" : "gauge").append("\n");
+    text.append(info.name).append(" ").append(value).append("\n");
+  }
+}
+
+void MetricsRegistry::startExporter(const std::string &target,
+                                    double intervalSeconds)
+{
+  stopExporter();
+  _exporting = true;
+  _exporter = std::thread{[this, target, intervalSeconds] {
+    // all memory of the exports is taken here once, so exporting doesn't
+    // show up in the allocation check
+    ExportTarget to{target};
+    to.text.reserve(2 * exportText().size());
+
+    const auto interval = std::chrono::duration<double>(intervalSeconds);
+    auto next = std::chrono::steady_clock::now() + interval;
+    while (_exporting)
+    {
+      // sleep in short steps, so stopping doesn't wait for a whole interval
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      if (std::chrono::steady_clock::now() < next)
+        continue;
+      exportTo(to);
+      next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          interval);
+    }
+    exportTo(to);
+  }};
+}
+
+void MetricsRegistry::stopExporter()
+{
+  if (!_exporter.joinable())
+    return;
+  _exporting = false;
+  _exporter.join();
+}
+
+MetricsRegistry::ExportTarget::ExportTarget(const std::string &target)
+    : path(target), temporary(target + ".tmp")
+{
+  const std::string unixPrefix{"unix:"};
+  isSocket = target.compare(0, unixPrefix.size(), unixPrefix) == 0;
+  if (isSocket)
+    path = target.substr(unixPrefix.size());
+}
+
+void MetricsRegistry::exportTo(ExportTarget &to) const
+{
+  std::string &text = to.text;
+  text.clear();
+  appendText(text);
+
+  if (to.isSocket)
+  {
+#if defined(METRICS_UNIX_SOCKET)
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (to.path.size() >= sizeof(address.sun_path))
+      return;
+    to.path.copy(address.sun_path, to.path.size());
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+      return;
+#if defined(SO_NOSIGPIPE)
+    int noSigpipe{1};
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &noSigpipe, sizeof(noSigpipe));
+#endif
+    // nobody listening is fine, the next export tries again
+    if (connect(fd, reinterpret_cast<sockaddr *>(&address),
+                sizeof(address)) == 0)
+    {
+      for (size_t sent = 0; sent < text.size();)
+      {
+        ssize_t n = send(fd, text.data() + sent, text.size() - sent,
+                         METRICS_SEND_FLAGS);
+        if (n <= 0)
+          break;
+        sent += static_cast<size_t>(n);
+      }
+    }
+    close(fd);
+#endif
+    return;
+  }
+
+  // write a temporary file first, readers never see a partial export. The
+  // stream gets a buffer of its own, it would allocate one otherwise.
+  {
+    char buffer[4096];
+    std::ofstream file;
+    file.rdbuf()->pubsetbuf(buffer, sizeof(buffer));
+    file.open(to.temporary);
+    file << text;
+  }
+  std::rename(to.temporary.c_str(), to.path.c_str());
+}
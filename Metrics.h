@@ -0,0 +1,153 @@
+#ifndef METRICS_H__
+#define METRICS_H__
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+/// Metrics of a running game, exported for monitoring.
+enum class METRIC : int
+{
+  FRAMES,
+  FRAME_SECONDS,
+  HITCHES,
+  HANDLE_EVENTS_SECONDS,
+  UPDATE_SECONDS,
+  DRAW_SECONDS,
+  ENEMIES_ALIVE,
+  ROCKETS_IN_USE,
+  BOMBS_IN_USE,
+  FRAME_ARENA_HIGH_WATER_BYTES,
+  INPUT_LATENCY_P50_SECONDS,
+  INPUT_LATENCY_P99_SECONDS,
+  LEVEL,
+  SCORE,
+  HIGHSCORE,
+  BOT_DECISIONS,
+  BOT_DECISION_SECONDS,
+  BOT_SIMULATED_TICKS,
+  SPECTATOR_MESSAGES,
+  SPECTATOR_BYTES,
+  SPECTATOR_DROPPED_MESSAGES,
+  SPECTATOR_SECONDS,
+  CAPTURED_FRAMES,
+  CAPTURE_DROPPED_FRAMES,
+  ATLAS_BUILD_SECONDS,
+  COUNT
+};
+
+/// Registry of all METRIC values. Counters are kept per thread, every thread
+/// only writes its own cache line, so adding to a counter is a plain load
+/// and store without any locked instruction. Gauges are single values that
+/// are overwritten. A background thread sums the threads up periodically
+/// and writes the result in the Prometheus text format.
+class MetricsRegistry
+{
+public:
+  /// Threads beyond this count share one slot with atomic adds.
+  static const int MAX_THREADS{16};
+
+  MetricsRegistry() = default;
+  ~MetricsRegistry();
+
+  MetricsRegistry(const MetricsRegistry &) = delete;
+  MetricsRegistry &operator=(const MetricsRegistry &) = delete;
+
+  /// Adds to a counter, a few nanoseconds per call. Times are counted in
+  /// nanoseconds and exported in seconds.
+  void add(METRIC metric, std::int64_t value = 1)
+  {
+    const int slot = threadSlot();
+    std::atomic<std::int64_t> &v =
+        _threads[slot].values[static_cast<int>(metric)];
+    if (slot == SHARED_SLOT)
+      v.fetch_add(value, std::memory_order_relaxed);
+    else
+      v.store(v.load(std::memory_order_relaxed) + value,
+              std::memory_order_relaxed);
+  }
+
+  /// Overwrites a gauge.
+  void set(METRIC metric, std::int64_t value)
+  {
+    _gauges[static_cast<int>(metric)].store(value, std::memory_order_relaxed);
+  }
+
+  /// Sum of a counter over all threads, or the value of a gauge.
+  std::int64_t get(METRIC metric) const;
+
+  /// Returns all metrics in the Prometheus text format.
+  std::string exportText() const;
+
+  /// Starts a thread that writes the metrics every intervalSeconds. A target
+  /// starting with "unix:" is a Unix domain socket the text is sent to,
+  /// everything else a file that is replaced atomically.
+  void startExporter(const std::string &target, double intervalSeconds);
+
+  /// Stops the exporter thread after a last export.
+  void stopExporter();
+
+private:
+  static const int METRIC_COUNT{static_cast<int>(METRIC::COUNT)};
+  static const int SHARED_SLOT{MAX_THREADS};
+
+  /// Counters of one thread on their own cache lines.
+  struct alignas(64) ThreadValues
+  {
+    std::array<std::atomic<std::int64_t>, METRIC_COUNT> values{};
+  };
+
+  /// Where the exporter writes to, and the text it reuses.
+  struct ExportTarget
+  {
+    explicit ExportTarget(const std::string &target);
+
+    bool isSocket{false};
+    /// File or socket path, and the temporary file written first
+    std::string path;
+    std::string temporary;
+    std::string text;
+  };
+
+  static int threadSlot();
+
+  void appendText(std::string &text) const;
+  void exportTo(ExportTarget &to) const;
+
+  std::array<ThreadValues, MAX_THREADS + 1> _threads{};
+  std::array<std::atomic<std::int64_t>, METRIC_COUNT> _gauges{};
+
+  std::atomic<bool> _exporting{false};
+  std::thread _exporter;
+};
+
+/// Adds the time spent in its scope to a counter, in nanoseconds. The two
+/// reads of the steady clock cost far more than the add, tens of
+/// nanoseconds, more in virtual machines, so it times phases of a frame and
+/// not single objects. The stress mode prints the cost of both.
+class ScopedMetricTimer
+{
+public:
+  ScopedMetricTimer(MetricsRegistry &metrics, METRIC metric)
+      : _metrics(metrics), _metric(metric),
+        _start(std::chrono::steady_clock::now())
+  {
+  }
+
+  ~ScopedMetricTimer()
+  {
+    _metrics.add(_metric, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::steady_clock::now() - _start)
+                              .count());
+  }
+
+private:
+  MetricsRegistry &_metrics;
+  METRIC _metric;
+  std::chrono::steady_clock::time_point _start;
+};
+
+#endif // METRICS_H__
@@ -0,0 +1,361 @@
+#include <algorithm>
+#include <limits>
+
+#include "ReferenceSimulation.h"
+
+/// Same as BoundingBox::intersectsWith.
+static bool isInside(const BoundingBox &box, const ReferenceObject &o)
+{
+  Position pos = o.getPosition();
+  return (pos._x >= box.left && pos._x <= box.right && pos._y >= box.top &&
+          pos._y <= box.bottom);
+}
+
+template <typename T, size_t SIZE>
+static BoundingBox getBoundingBoxOf(const std::array<T, SIZE> &arr)
+{
+  bool atLeastOneEnemyAlive{false};
+
+  float left{std::numeric_limits<float>::max()};
+  float top{std::numeric_limits<float>::max()};
+  float right{std::numeric_limits<float>::min()};
+  float bottom{std::numeric_limits<float>::min()};
+  for (const auto &o : arr)
+  {
+    if (!o.isAlive())
+      continue;
+
+    atLeastOneEnemyAlive = true;
+
+    Position pos = o.getPosition();
+    if (pos._x < left)
+      left = pos._x;
+    if (pos._y < top)
+      top = pos._y;
+    if (pos._x > right)
+      right = pos._x;
+    if (pos._y > bottom)
+      bottom = pos._y;
+  }
+
+  if (atLeastOneEnemyAlive)
+  {
+    // The origin position of a sprite is the middle, therefore the
+    // bounding box is expanded in all directions by half the sprite size
+    left -= Engine::SpriteSize / 2;
+    top -= Engine::SpriteSize / 2;
+    right += Engine::SpriteSize / 2;
+    bottom += Engine::SpriteSize / 2;
+
+    return {left, top, right, bottom};
+  }
+  else
+  {
+    return {};
+  }
+}
+
+template <typename Cfg>
+ReferenceSimulation<Cfg>::ReferenceSimulation()
+{
+  _dis = std::uniform_int_distribution<int>{0, Cfg::ENEMY_COUNT - 1};
+  reset();
+}
+
+template <typename Cfg>
+void ReferenceSimulation<Cfg>::reset(RESET reset)
+{
+  if (reset == RESET::ALSO_PLAYER_POSITION)
+  {
+    initPlayer();
+  }
+
+  _player.setHealth(Cfg::PLAYER_HEALTH);
+  _gameOver = false;
+
+  initEnemies();
+  for (auto &r : _rockets)
+    r.setHealth(0);
+  for (auto &b : _bombs)
+    b.setHealth(0);
+}
+
+template <typename Cfg>
+void ReferenceSimulation<Cfg>::tick(const Engine::PlayerInput &keys,
+                                    bool firePressed, double now,
+                                    double seconds)
+{
+  _currentTimestamp = now;
+  _msPerFrame = seconds;
+
+  if (firePressed)
+  {
+    if (_currentTimestamp - _timestampOfLastShot >
+        Cfg::TIME_BETWEEN_SHOTS) // restrict shooting per second
+    {
+      for (auto &r : _rockets)
+      {
+        if (!r.isAlive())
+        {
+          _timestampOfLastShot = _currentTimestamp;
+          r.setPosition(_player.getPosition());
+          r.setHealth(1);
+          break;
+        }
+      }
+    }
+  }
+
+  if (keys.left)
+  {
+    Position pos = _player.getPosition();
+    if (pos._x > 0)
+    {
+      _player.setPositionX(pos._x - 400 * _msPerFrame);
+    }
+  }
+
+  if (keys.right)
+  {
+    Position pos = _player.getPosition();
+    if (pos._x < Engine::CanvasWidth - Engine::SpriteSize)
+    {
+      _player.setPositionX(pos._x + 400 * _msPerFrame);
+    }
+  }
+
+  updateEnemies();
+  updateBombs();
+  updateRockets();
+}
+
+template <typename Cfg>
+void ReferenceSimulation<Cfg>::initPlayer()
+{
+  float posX = Engine::CanvasWidth / 2;
+  float posY = Engine::CanvasHeight - (Engine::SpriteSize / 2);
+  _player.setPosition({posX, posY});
+}
+
+template <typename Cfg>
+void ReferenceSimulation<Cfg>::initEnemies()
+{
+  // the origin of the enemies is right below the top bar
+  int startY{Engine::FontRowHeight + 10};
+
+  int i{0};
+  for (auto &e : _enemies)
+  {
+    float col = (i / Cfg::ENEMY_ROWS);
+    float row = (i % Cfg::ENEMY_ROWS);
+    e.setPosition(
+        {col * Engine::SpriteSize + (Engine::SpriteSize / 2),
+         startY + row * Engine::SpriteSize + +(Engine::SpriteSize / 2)});
+    e.setHealth(1);
+    ++i;
+  }
+
+  _enemyBbox = getBoundingBoxOf(_enemies);
+  _enemyBboxOriginal = _enemyBbox;
+}
+
+template <typename Cfg>
+void ReferenceSimulation<Cfg>::updateRockets()
+{
+  for (auto &r : _rockets)
+  {
+    if (r.isAlive())
+    {
+      Position pos = r.getPosition();
+
+      if (pos._y > -Engine::SpriteSize)
+      {
+        r.setPositionY(pos._y - 1);
+      }
+      else
+      {
+        r.destroy();
+      }
+    }
+  }
+}
+
+template <typename Cfg>
+void ReferenceSimulation<Cfg>::updateBombs()
+{
+  for (auto &b : _bombs)
+  {
+    if (b.isAlive())
+    {
+      Position pos = b.getPosition();
+      if (pos._y > Engine::CanvasHeight)
+      {
+        b.destroy();
+      }
+      else if (b.intersectsWith(_player))
+      {
+        b.destroy();
+        _player.hit();
+        if (!_player.isAlive())
+        {
+          _gameOver = true;
+          return;
+        }
+      }
+      else
+      {
+        b.setPositionY(pos._y + 150 * _msPerFrame);
+      }
+    }
+    else
+    {
+      // case to drop bombs, which are restricted to drop by time
+      if (_currentTimestamp - _timestampOfLastBomb < Cfg::TIME_BETWEEN_BOMBS)
+        continue;
+
+      // iterate through all alive enemies (repeat over at the end)
+      // until the random generated index is hit
+      int index = _dis(_rd);
+      auto it = _enemies.begin();
+      do
+      {
+        if (it == _enemies.end())
+          it = _enemies.begin();
+
+        if (it->isAlive())
+        {
+          if (index == 0)
+          {
+            _timestampOfLastBomb = _currentTimestamp;
+            b.setPosition(it->getPosition());
+            b.setHealth(1);
+          }
+        }
+        it++;
+      } while (index-- > 0);
+    }
+  }
+}
+
+template <typename Cfg>
+void ReferenceSimulation<Cfg>::updateEnemies()
+{
+  if (_enemyBbox.bottom >= Engine::CanvasHeight)
+  {
+    _gameOver = true;
+    return;
+  }
+  else if (isInside(_enemyBbox, _player))
+  {
+    for (auto &e : _enemies)
+    {
+      // GameEngine also let destroyed enemies hit the player, which was
+      // fixed together with the alive masks
+      if (e.isAlive() && e.intersectsWith(_player))
+      {
+        e.destroy();
+        _player.hit();
+
+        if (!_player.isAlive())
+        {
+          _gameOver = true;
+          return;
+        }
+        break;
+      }
+    }
+  }
+
+  // destroy an enemy if it got hit by a rocket
+  bool enemyDied{false};
+  for (auto &r : _rockets)
+  {
+    if (!r.isAlive())
+      continue;
+
+    if (!isInside(_enemyBbox, r))
+      continue;
+    Position rpos = r.getPosition();
+
+    int column =
+        int(float(rpos._x - _enemyBboxOriginal.left) / Engine::SpriteSize);
+
+    if (column > Cfg::ENEMY_COLS || column < 0)
+      continue;
+    else if (column == Cfg::ENEMY_COLS)
+      column--;
+
+    // iterate through all enemies of that column from bottom to top
+    int end = column * Cfg::ENEMY_ROWS;
+    for (int i = (column + 1) * Cfg::ENEMY_ROWS - 1; i >= end; --i)
+    {
+      ReferenceObject &e = _enemies[i];
+      if (e.isAlive() && e.intersectsWith(r))
+      {
+        r.destroy();
+        e.destroy();
+
+        enemyDied = true;
+        _hscore.addScore();
+        break;
+      }
+    }
+  }
+
+  if (enemyDied)
+  {
+    bool atLeastOneEnemyAlive =
+        std::any_of(_enemies.begin(), _enemies.end(),
+                    [](const ReferenceObject &e) { return e.isAlive(); });
+    if (!atLeastOneEnemyAlive)
+    {
+      initEnemies();
+      ++_level;
+    }
+    else
+    {
+      _enemyBbox = getBoundingBoxOf(_enemies);
+    }
+  }
+
+  // move all enemies in travel direction
+  float travelStepX{0};
+  float travelStepY{0};
+  if (_enemy_direction == ENEMY_DIRECTION::RIGHT)
+  {
+    if (_enemyBbox.right < Engine::CanvasWidth)
+    {
+      travelStepX = 200 * _msPerFrame;
+    }
+    else
+    {
+      travelStepY = 10 * _level; // down step is dependend on level
+      _enemy_direction = ENEMY_DIRECTION::LEFT;
+      travelStepX = -1;
+    }
+  }
+  else
+  {
+    if (_enemyBbox.left > 0)
+    {
+      travelStepX = -(200 * _msPerFrame);
+    }
+    else
+    {
+      travelStepY = 10 * _level; // down step is dependend on level
+      _enemy_direction = ENEMY_DIRECTION::RIGHT;
+      travelStepX = 1;
+    }
+  }
+
+  for (auto &e : _enemies)
+  {
+    e.setPositionX(e.getPosition()._x + travelStepX);
+    e.setPositionY(e.getPosition()._y + travelStepY);
+  }
+
+  _enemyBbox.moveBy({travelStepX, travelStepY});
+  _enemyBboxOriginal.moveBy({travelStepX, travelStepY});
+}
+
+template class ReferenceSimulation<Config>;
@@ -0,0 +1,122 @@
+#ifndef REFERENCE_SIMULATION_H__
+#define REFERENCE_SIMULATION_H__
+
+#include <array>
+#include <random>
+
+#include "Config.h"
+#include "Engine.h"
+#include "GameObjects.h"
+#include "GameSimulation.h"
+
+/// Game object as the game stored it before the objects were packed: a float
+/// position and an int health that tells if the object is alive.
+class ReferenceObject
+{
+public:
+  void setPosition(Position pos) { _pos = pos; }
+
+  Position getPosition() const { return _pos; }
+
+  void setPositionX(float posX) { _pos._x = posX; }
+
+  void setPositionY(float posY) { _pos._y = posY; }
+
+  void destroy() { setHealth(0); }
+
+  void setHealth(int health) { _health = health; }
+
+  void hit() { --_health; }
+
+  bool isAlive() const { return _health > 0; }
+
+  int getHealth() const { return _health; }
+
+  bool intersectsWith(const ReferenceObject &o,
+                      float radius = Engine::SpriteSize / 2) const
+  {
+    float dx = (_pos._x - o._pos._x);
+    float dy = (_pos._y - o._pos._y);
+    return sqrt(dx * dx + dy * dy) <= radius;
+  }
+
+private:
+  Position _pos;
+  int _health{0};
+};
+
+/// The rules of the game as GameEngine implemented them before any of the
+/// optimizations: arrays of ReferenceObject that are all visited every
+/// update, cooldowns compared against the timestamps of the last shot and
+/// bomb, and bombs dropped in the same loop that moves them. It is slow on
+/// purpose and only meant as the model the optimized GameSimulation is
+/// checked against (see SoakTest).
+///
+/// The one deliberate rule change since then is kept: only alive enemies
+/// collide with the player (see updateEnemies).
+template <typename Cfg = Config>
+class ReferenceSimulation
+{
+public:
+  using Enemies = std::array<ReferenceObject, Cfg::ENEMY_COUNT>;
+  using Bombs = std::array<ReferenceObject, Cfg::MAX_BOMB_COUNT>;
+  using Rockets = std::array<ReferenceObject, Cfg::MAX_ROCKET_COUNT>;
+
+  ReferenceSimulation();
+
+  void seed(unsigned seed) { _rd.seed(seed); }
+
+  void reset(RESET reset = RESET::ALSO_PLAYER_POSITION);
+
+  /// One frame of GameEngine::handleEvents and GameEngine::update in the
+  /// play state: the fire key, the movement and the update.
+  /// @param firePressed The fire key went down in this frame.
+  /// @param now Time of the frame. The timestamps of the last shot and bomb
+  /// start at 0 like in GameEngine, where play begins after the countdown.
+  /// @param seconds Time since the last frame.
+  void tick(const Engine::PlayerInput &keys, bool firePressed, double now,
+            double seconds);
+
+  bool isGameOver() const { return _gameOver; }
+
+  const ReferenceObject &getPlayer() const { return _player; }
+  const Enemies &getEnemies() const { return _enemies; }
+  const Rockets &getRockets() const { return _rockets; }
+  const Bombs &getBombs() const { return _bombs; }
+  int getLevel() const { return _level; }
+  Highscore &getHighscore() { return _hscore; }
+  const Highscore &getHighscore() const { return _hscore; }
+
+private:
+  void initPlayer();
+  void initEnemies();
+  void updateEnemies();
+  void updateRockets();
+  void updateBombs();
+
+  ENEMY_DIRECTION _enemy_direction{ENEMY_DIRECTION::RIGHT};
+  Highscore _hscore;
+  int _level{1};
+  bool _gameOver{false};
+
+  double _currentTimestamp{0.0};
+  double _timestampOfLastShot{0.0};
+  double _timestampOfLastBomb{0.0};
+  double _msPerFrame{0.0};
+
+  ReferenceObject _player;
+  Rockets _rockets;
+  Bombs _bombs;
+  Enemies _enemies;
+
+  BoundingBox _enemyBbox;
+  BoundingBox _enemyBboxOriginal;
+
+  std::default_random_engine _rd;
+  std::uniform_int_distribution<int> _dis;
+};
+
+// defined and instantiated in ReferenceSimulation.cpp
+extern template class ReferenceSimulation<Config>;
+
+#endif // REFERENCE_SIMULATION_H__
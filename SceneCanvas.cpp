@@ -0,0 +1,142 @@
+#include <cstdio>
+#include <cstring>
+
+#include "SceneCanvas.h"
+
+#if defined(SOFTWARE_RENDERER)
+SceneCanvas::SceneCanvas(Engine &engine, FrameArena &arena,
+                         SoftwareRenderer &renderer)
+    : SceneCanvas(engine, arena)
+{
+  _renderer = &renderer;
+  // rasterized with the first frame, the host sets the glyphs after the
+  // canvas is constructed
+  renderer.prepareTexts({"Welcome", "3", "2", "1", "Go!", "Game Over :-(",
+                         "Press space to try again"});
+}
+#endif
+
+void SceneCanvas::beginFrame()
+{
+  // the storage of the previous list was released with the arena
+  _items = DrawList{ArenaAllocator<Item>{_arena}};
+  _items.reserve(_lastItemCount);
+}
+
+void SceneCanvas::submit()
+{
+  for (const Item &item : _items)
+  {
+#if defined(SOFTWARE_RENDERER)
+    if (_renderer)
+    {
+      if (item.text)
+        _renderer->drawText(item.text, item.x, item.y);
+      else
+        _renderer->drawSprite(item.sprite, item.x, item.y);
+      continue;
+    }
+#endif
+    if (item.text)
+      _engine.drawText(item.text, item.x, item.y);
+    else
+      _engine.drawSprite(item.sprite, item.x, item.y);
+  }
+  _lastItemCount = _items.size();
+}
+
+void SceneCanvas::drawSprite(Engine::Sprite sprite, int x, int y)
+{
+  _items.push_back({nullptr, sprite, x, y});
+}
+
+void SceneCanvas::drawText(const char *message, int x, int y)
+{
+  const size_t size = strlen(message) + 1;
+  char *text = static_cast<char *>(_arena.allocate(size, 1));
+  memcpy(text, message, size);
+  _items.push_back({text, Engine::Sprite::Player, x, y});
+}
+
+void SceneCanvas::drawObject(Engine::Sprite sprite, Position pos)
+{
+  drawSprite(sprite, int(pos._x - Engine::SpriteSize / 2),
+             int(pos._y - Engine::SpriteSize / 2));
+}
+
+template <typename T, int SIZE>
+void SceneCanvas::drawObjects(Engine::Sprite sprite,
+                              const ObjectPool<T, SIZE> &pool)
+{
+  for (int i : pool.alive())
+    drawObject(sprite, pool[i].getPosition());
+}
+
+void SceneCanvas::drawEnemy(int index, Position pos)
+{
+  bool altSprite = (index & 1) != 0;
+  drawObject(altSprite ? Engine::Sprite::Enemy1 : Engine::Sprite::Enemy2,
+             pos);
+}
+
+void SceneCanvas::drawHealth(int health)
+{
+  for (int i = 0; i < health; ++i)
+    drawSprite(Engine::Sprite::Player, (i * Engine::SpriteSize), 5);
+}
+
+void SceneCanvas::drawScores(int score, int highscore)
+{
+  // formatted on the stack, drawText copies it into the frame arena
+  char text[64];
+  int length = snprintf(text, sizeof(text), "Current Score: %d", score);
+  drawText(text, (Engine::CanvasWidth - length * Engine::FontWidth) / 2,
+           Engine::SpriteSize - Engine::FontRowHeight);
+  length = snprintf(text, sizeof(text), "Highscore: %d", highscore);
+  drawText(text, Engine::CanvasWidth - length * Engine::FontWidth,
+           Engine::SpriteSize - Engine::FontRowHeight);
+}
+
+void SceneCanvas::drawMessage(GAMESTATE state, bool showTryAgainPrompt)
+{
+  switch (state)
+  {
+  case GAMESTATE::PLAY:
+    return;
+  case GAMESTATE::GAMEOVER:
+    drawCenteredText("Game Over :-(");
+    // display the message 2 seconds after game over
+    if (showTryAgainPrompt)
+      drawCenteredText("Press space to try again", 2);
+    return;
+  case GAMESTATE::WELCOME:
+    drawCenteredText("Welcome");
+    return;
+  case GAMESTATE::WELCOME_3:
+    drawCenteredText("3");
+    return;
+  case GAMESTATE::WELCOME_2:
+    drawCenteredText("2");
+    return;
+  case GAMESTATE::WELCOME_1:
+    drawCenteredText("1");
+    return;
+  case GAMESTATE::GO:
+  default:
+    drawCenteredText("Go!");
+    return;
+  }
+}
+
+void SceneCanvas::drawCenteredText(const char *message, int row)
+{
+  int width = (static_cast<int>(strlen(message)) - 1) * Engine::FontWidth;
+  drawText(message, (Engine::CanvasWidth - width) / 2,
+           (Engine::CanvasHeight - Engine::FontRowHeight) / 2 +
+               row * Engine::FontRowHeight);
+}
+
+template void SceneCanvas::drawObjects(
+    Engine::Sprite, const ObjectPool<Rocket, Config::MAX_ROCKET_COUNT> &);
+template void SceneCanvas::drawObjects(
+    Engine::Sprite, const ObjectPool<Bomb, Config::MAX_BOMB_COUNT> &);
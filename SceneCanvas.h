@@ -0,0 +1,95 @@
+#ifndef SCENE_CANVAS_H__
+#define SCENE_CANVAS_H__
+
+#include <vector>
+
+#include "Engine.h"
+#include "FrameArena.h"
+#include "GameObjects.h"
+#include "GameSimulation.h"
+
+#if defined(SOFTWARE_RENDERER)
+#include "SoftwareRenderer.h"
+#endif
+
+/// Draws the scene and the hud of the game. The game and the spectator
+/// viewer both draw through it, so a spectator sees what the player sees.
+///
+/// The draw calls of a frame are recorded into a draw list and submitted to
+/// the engine or the software renderer at the end of the frame. The list and
+/// the copies of the texts, e.g. the scores, live in the frame arena.
+class SceneCanvas
+{
+public:
+  /// Draws with the engine.
+  SceneCanvas(Engine &engine, FrameArena &arena)
+      : _engine(engine), _arena(arena), _items(ArenaAllocator<Item>{arena})
+  {
+  }
+#if defined(SOFTWARE_RENDERER)
+  /// Draws with the software renderer instead of the engine. The messages
+  /// of drawMessage are prepared in the renderer.
+  SceneCanvas(Engine &engine, FrameArena &arena, SoftwareRenderer &renderer);
+#endif
+
+  /// Starts a new draw list. The frame arena has to be reset since the last
+  /// frame.
+  void beginFrame();
+
+  /// Executes the draw list.
+  void submit();
+
+  void drawSprite(Engine::Sprite sprite, int x, int y);
+  /// The message is copied, it only has to be valid during the call.
+  void drawText(const char *message, int x, int y);
+
+  /// Draws a sprite centered on the position of an object.
+  void drawObject(Engine::Sprite sprite, Position pos);
+
+  /// Draws the alive objects of a pool.
+  template <typename T, int SIZE>
+  void drawObjects(Engine::Sprite sprite, const ObjectPool<T, SIZE> &pool);
+
+  /// Draws an enemy, the sprites alternate by index, no matter if the
+  /// neighbours are destroyed.
+  void drawEnemy(int index, Position pos);
+
+  /// Draws one player sprite per health point in the top left corner.
+  void drawHealth(int health);
+
+  /// Draws the current score centered and the highscore right aligned at
+  /// the top.
+  void drawScores(int score, int highscore);
+
+  /// Draws the message of a game state centered on the canvas, nothing while
+  /// playing.
+  /// @param showTryAgainPrompt Adds the prompt below the game over message.
+  void drawMessage(GAMESTATE state, bool showTryAgainPrompt);
+
+  /// Draws a text centered on the canvas, rows below the middle.
+  void drawCenteredText(const char *message, int row = 0);
+
+private:
+  /// Draw call of the list, a text if text is set and a sprite otherwise.
+  struct Item
+  {
+    const char *text;
+    Engine::Sprite sprite;
+    int x;
+    int y;
+  };
+
+  using DrawList = std::vector<Item, ArenaAllocator<Item>>;
+
+  Engine &_engine;
+  FrameArena &_arena;
+#if defined(SOFTWARE_RENDERER)
+  SoftwareRenderer *_renderer{nullptr};
+#endif
+
+  DrawList _items;
+  /// Size of the last list, the next one starts with room for as many
+  size_t _lastItemCount{0};
+};
+
+#endif // SCENE_CANVAS_H__
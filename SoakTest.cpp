@@ -0,0 +1,289 @@
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <random>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#include "AllocationCounter.h"
+#include "SoakTest.h"
+
+/// FNV-1a over the values of a state.
+class StateHash
+{
+public:
+  void add(std::int64_t value)
+  {
+    for (int i = 0; i < 8; ++i)
+    {
+      _hash ^= static_cast<std::uint64_t>(value >> (i * 8)) & 0xff;
+      _hash *= 1099511628211ull;
+    }
+  }
+
+  /// Positions are hashed by their bits, like they are compared.
+  void add(Position pos)
+  {
+    add(bitsOf(pos._x));
+    add(bitsOf(pos._y));
+  }
+
+  std::uint64_t get() const { return _hash; }
+
+private:
+  static std::int64_t bitsOf(float value)
+  {
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+  }
+
+  std::uint64_t _hash{14695981039346656037ull};
+};
+
+template <typename Pool, size_t SIZE>
+static std::uint64_t takePool(const Pool &pool,
+                              std::array<Position, SIZE> &positions)
+{
+  for (int i : pool.alive())
+    positions[i] = pool[i].getPosition();
+  return pool.aliveMask();
+}
+
+template <size_t SIZE>
+static std::uint64_t
+takeArray(const std::array<ReferenceObject, SIZE> &objects,
+          std::array<Position, SIZE> &positions)
+{
+  std::uint64_t alive{0};
+  for (size_t i = 0; i < SIZE; ++i)
+  {
+    if (!objects[i].isAlive())
+      continue;
+    positions[i] = objects[i].getPosition();
+    alive |= std::uint64_t{1} << i;
+  }
+  return alive;
+}
+
+SoakState::SoakState(const GameSimulation<Config> &sim)
+    : gameOver(sim.isGameOver()), level(sim.getLevel()),
+      score(sim.getHighscore().getCurrentScore()),
+      highscore(sim.getHighscore().getHighscore()),
+      player(sim.getPlayer().getPosition()),
+      health(sim.getPlayer().getHealth())
+{
+  enemiesAlive = takePool(sim.getEnemies(), enemies);
+  rocketsAlive = takePool(sim.getRockets(), rockets);
+  bombsAlive = takePool(sim.getBombs(), bombs);
+}
+
+SoakState::SoakState(const ReferenceSimulation<Config> &sim)
+    : gameOver(sim.isGameOver()), level(sim.getLevel()),
+      score(sim.getHighscore().getCurrentScore()),
+      highscore(sim.getHighscore().getHighscore()),
+      player(sim.getPlayer().getPosition()),
+      health(sim.getPlayer().getHealth())
+{
+  enemiesAlive = takeArray(sim.getEnemies(), enemies);
+  rocketsAlive = takeArray(sim.getRockets(), rockets);
+  bombsAlive = takeArray(sim.getBombs(), bombs);
+}
+
+std::uint64_t SoakState::hash() const
+{
+  StateHash hash;
+  hash.add(gameOver);
+  hash.add(level);
+  hash.add(score);
+  hash.add(highscore);
+  hash.add(player);
+  hash.add(health);
+  hash.add(static_cast<std::int64_t>(enemiesAlive));
+  hash.add(static_cast<std::int64_t>(rocketsAlive));
+  hash.add(static_cast<std::int64_t>(bombsAlive));
+  for (int i : AliveIndices{enemiesAlive})
+    hash.add(enemies[i]);
+  for (int i : AliveIndices{rocketsAlive})
+    hash.add(rockets[i]);
+  for (int i : AliveIndices{bombsAlive})
+    hash.add(bombs[i]);
+  return hash.get();
+}
+
+static bool isEqual(Position a, Position b)
+{
+  return a._x == b._x && a._y == b._y;
+}
+
+template <size_t SIZE>
+static bool areEqual(const std::array<Position, SIZE> &a,
+                    const std::array<Position, SIZE> &b, std::uint64_t alive)
+{
+  for (int i : AliveIndices{alive})
+  {
+    if (!isEqual(a[i], b[i]))
+      return false;
+  }
+  return true;
+}
+
+bool SoakState::operator==(const SoakState &o) const
+{
+  return gameOver == o.gameOver && level == o.level && score == o.score &&
+         highscore == o.highscore && health == o.health &&
+         enemiesAlive == o.enemiesAlive && rocketsAlive == o.rocketsAlive &&
+         bombsAlive == o.bombsAlive && isEqual(player, o.player) &&
+         areEqual(enemies, o.enemies, enemiesAlive) &&
+         areEqual(rockets, o.rockets, rocketsAlive) &&
+         areEqual(bombs, o.bombs, bombsAlive);
+}
+
+template <size_t SIZE>
+static void dumpObjects(const char *name,
+                        const std::array<Position, SIZE> &positions,
+                        std::uint64_t alive, std::FILE *out)
+{
+  for (int i : AliveIndices{alive})
+  {
+    std::fprintf(out, "  %s %2d: %.9g %.9g\n", name, i, positions[i]._x,
+                 positions[i]._y);
+  }
+}
+
+void SoakState::dump(std::FILE *out) const
+{
+  std::fprintf(out,
+               "  hash %016llx game over %d level %d score %d "
+               "highscore %d\n",
+               static_cast<unsigned long long>(hash()), gameOver, level,
+               score, highscore);
+  std::fprintf(out, "  player: %.9g %.9g health %d\n", player._x,
+               player._y, health);
+  dumpObjects("enemy", enemies, enemiesAlive, out);
+  dumpObjects("rocket", rockets, rocketsAlive, out);
+  dumpObjects("bomb", bombs, bombsAlive, out);
+}
+
+long SoakTest::getResidentKiB()
+{
+#if defined(__linux__)
+  long pages{0};
+  long resident{0};
+  if (std::FILE *statm = std::fopen("/proc/self/statm", "r"))
+  {
+    if (std::fscanf(statm, "%ld %ld", &pages, &resident) != 2)
+      resident = -1;
+    std::fclose(statm);
+    return resident < 0 ? -1 : resident * (sysconf(_SC_PAGESIZE) / 1024);
+  }
+  return -1;
+#elif defined(__APPLE__)
+  // only the peak is available without mach calls, in bytes
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss / 1024;
+#else
+  return -1;
+#endif
+}
+
+SoakTest::Result SoakTest::run(std::int64_t maxTicks, double reportSeconds,
+                               std::FILE *out)
+{
+  using Clock = std::chrono::steady_clock;
+
+  Result result;
+  std::default_random_engine rd{_seed};
+  std::uniform_int_distribution<int> key{0, 3};
+  // every segment runs at its own frame rate, log uniform between 20 and
+  // 20000 fps, with a jitter of 10% per frame
+  std::uniform_real_distribution<double> logFps{std::log(20.0),
+                                                std::log(20000.0)};
+  std::uniform_int_distribution<int> segmentTicks{1, 2000};
+  std::uniform_real_distribution<double> jitter{0.9, 1.1};
+
+  // play starts after the welcome countdown, as in the game
+  double now{6.0};
+  _optimized = GameSimulation<Config>{};
+  _reference = ReferenceSimulation<Config>{};
+  _optimized.seed(_seed);
+  _reference.seed(_seed);
+  _optimized.start(now);
+
+  double frameSeconds{0.0};
+  int ticksLeftInSegment{0};
+  bool fireHeld{false};
+  Clock::time_point lastReport = Clock::now();
+  Clock::time_point nextReport = lastReport;
+  std::int64_t ticksAtReport{0};
+  for (; maxTicks == 0 || result.ticks < maxTicks; ++result.ticks)
+  {
+    if (ticksLeftInSegment-- == 0)
+    {
+      frameSeconds = 1.0 / std::exp(logFps(rd));
+      ticksLeftInSegment = segmentTicks(rd);
+    }
+    const double seconds = frameSeconds * jitter(rd);
+    now += seconds;
+    Engine::PlayerInput keys{key(rd) == 0, key(rd) == 0, key(rd) != 0};
+    const bool firePressed = keys.fire && !fireHeld;
+    fireHeld = keys.fire;
+
+    _optimized.tick(keys, firePressed, now, seconds);
+    _reference.tick(keys, firePressed, now, seconds);
+
+    const SoakState optimized{_optimized};
+    const SoakState reference{_reference};
+    if (optimized != reference)
+    {
+      result.diverged = true;
+      std::fprintf(out,
+                   "diverged at tick %lld (seed %u, time %.6f, frame %.6f, "
+                   "keys %d%d%d fire pressed %d)\noptimized:\n",
+                   static_cast<long long>(result.ticks), _seed, now, seconds,
+                   keys.left, keys.right, keys.fire, firePressed);
+      optimized.dump(out);
+      std::fprintf(out, "reference:\n");
+      reference.dump(out);
+      break;
+    }
+
+    // try again right away, like a player pressing fire after a game over
+    if (_optimized.isGameOver())
+    {
+      _optimized.reset(RESET::BUT_NOT_THE_PLAYER);
+      _optimized.getHighscore().finishScore();
+      _reference.reset(RESET::BUT_NOT_THE_PLAYER);
+      _reference.getHighscore().finishScore();
+      ++result.restarts;
+    }
+
+    // the clock is only read every few ticks, it costs more than a tick
+    if ((result.ticks & 0x3ff) == 0 && Clock::now() >= nextReport)
+    {
+      const Clock::time_point time = Clock::now();
+      const double elapsed =
+          std::chrono::duration<double>(time - lastReport).count();
+      std::fprintf(out,
+                   "%12lld ticks %10.0f ticks/s %8d restarts rss %8ld KiB "
+                   "allocations %lld live %lld\n",
+                   static_cast<long long>(result.ticks),
+                   elapsed > 0 ? (result.ticks - ticksAtReport) / elapsed
+                               : 0.0,
+                   result.restarts, getResidentKiB(),
+                   static_cast<long long>(AllocationCounter::getCount()),
+                   static_cast<long long>(AllocationCounter::getLiveCount()));
+      std::fflush(out);
+      ticksAtReport = result.ticks;
+      lastReport = time;
+      nextReport = time + std::chrono::duration_cast<Clock::duration>(
+                              std::chrono::duration<double>(reportSeconds));
+    }
+  }
+
+  return result;
+}
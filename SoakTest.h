@@ -0,0 +1,78 @@
+#ifndef SOAK_TEST_H__
+#define SOAK_TEST_H__
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+
+#include "Config.h"
+#include "GameSimulation.h"
+#include "ReferenceSimulation.h"
+
+/// What the player sees of a simulation after a tick. Both simulations are
+/// turned into one, so they are hashed and compared the same way. Both run
+/// the same float arithmetic, positions are compared exactly.
+struct SoakState
+{
+  explicit SoakState(const GameSimulation<Config> &sim);
+  explicit SoakState(const ReferenceSimulation<Config> &sim);
+
+  std::uint64_t hash() const;
+
+  /// Equal, only the positions of alive objects are compared.
+  bool operator==(const SoakState &o) const;
+  bool operator!=(const SoakState &o) const { return !(*this == o); }
+
+  /// Writes the state in a readable form.
+  void dump(std::FILE *out) const;
+
+  bool gameOver{false};
+  int level{0};
+  int score{0};
+  int highscore{0};
+  Position player;
+  int health{0};
+  std::array<Position, Config::ENEMY_COUNT> enemies{};
+  std::array<Position, Config::MAX_ROCKET_COUNT> rockets{};
+  std::array<Position, Config::MAX_BOMB_COUNT> bombs{};
+  std::uint64_t enemiesAlive{0};
+  std::uint64_t rocketsAlive{0};
+  std::uint64_t bombsAlive{0};
+};
+
+/// Plays GameSimulation and ReferenceSimulation, the rules as GameEngine
+/// implemented them before the optimizations, side by side with the same
+/// seeded random inputs and frame lengths. Frame lengths run in segments of
+/// a random frame rate between 20 and 20000 fps, so rounding that only shows
+/// at high frame rates is covered too. The state hashes are compared after
+/// every tick, the first divergence stops the run and both states are
+/// dumped. Game overs restart both, so a run can go on for hours. The
+/// resident memory and, if built with COUNT_ALLOCATIONS, the heap
+/// allocations are reported periodically to catch leaks and growth.
+class SoakTest
+{
+public:
+  struct Result
+  {
+    std::int64_t ticks{0};
+    int restarts{0};
+    bool diverged{false};
+  };
+
+  /// @param seed Seed of the inputs and the bomb drops.
+  explicit SoakTest(unsigned seed) : _seed(seed) {}
+
+  /// Runs until the states diverge or maxTicks passed, 0 runs forever.
+  /// @param reportSeconds Interval of the progress written to out.
+  Result run(std::int64_t maxTicks, double reportSeconds, std::FILE *out);
+
+  /// Resident memory of the process in KiB, or -1 if unknown.
+  static long getResidentKiB();
+
+private:
+  unsigned _seed;
+  GameSimulation<Config> _optimized;
+  ReferenceSimulation<Config> _reference;
+};
+
+#endif // SOAK_TEST_H__
@@ -0,0 +1,452 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SOFTWARE_RENDERER_SSE2
+#endif
+
+#include "SoftwareRenderer.h"
+
+PixelRect PixelRect::clippedTo(const PixelRect &o) const
+{
+  return {std::max(left, o.left), std::max(top, o.top),
+          std::min(right, o.right), std::min(bottom, o.bottom)};
+}
+
+void PixelRect::merge(const PixelRect &o)
+{
+  left = std::min(left, o.left);
+  top = std::min(top, o.top);
+  right = std::max(right, o.right);
+  bottom = std::max(bottom, o.bottom);
+}
+
+const int SoftwareRenderer::SPRITE_COUNT;
+const int SoftwareRenderer::GLYPH_COUNT;
+const int SoftwareRenderer::MAX_CACHED_TEXTS;
+const int SoftwareRenderer::TEXT_ARENA_BYTES;
+const SoftwareRenderer::Pixel SoftwareRenderer::CLEAR_COLOR;
+
+static const PixelRect CANVAS_RECT{0, 0, Engine::CanvasWidth,
+                                   Engine::CanvasHeight};
+
+static int spriteIndex(Engine::Sprite sprite)
+{
+  switch (sprite)
+  {
+  case Engine::Sprite::Player:
+    return 0;
+  case Engine::Sprite::Enemy1:
+    return 1;
+  case Engine::Sprite::Enemy2:
+    return 2;
+  case Engine::Sprite::Rocket:
+    return 3;
+  case Engine::Sprite::Bomb:
+  default:
+    return 4;
+  }
+}
+
+/// Rounds a pixel count up to whole cache lines.
+static constexpr int alignToCacheLine(int pixels)
+{
+  return (pixels + 15) / 16 * 16;
+}
+
+static const int SPRITE_SLOT{
+    alignToCacheLine(Engine::SpriteSize * Engine::SpriteSize)};
+static const int GLYPH_SLOT{
+    alignToCacheLine(Engine::FontWidth * Engine::FontRowHeight)};
+static const int ATLAS_SIZE{SoftwareRenderer::SPRITE_COUNT * SPRITE_SLOT +
+                            SoftwareRenderer::GLYPH_COUNT * GLYPH_SLOT};
+
+/// Adds the time passed since start to the given seconds on destruction.
+class BuildTimer
+{
+public:
+  explicit BuildTimer(double &seconds)
+      : _seconds(seconds), _start(std::chrono::steady_clock::now())
+  {
+  }
+
+  ~BuildTimer()
+  {
+    _seconds += std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - _start)
+                    .count();
+  }
+
+private:
+  double &_seconds;
+  std::chrono::steady_clock::time_point _start;
+};
+
+/// FNV-1a, used to identify draw calls across frames
+static std::uint64_t hashBytes(const void *data, size_t size,
+                               std::uint64_t hash = 14695981039346656037ull)
+{
+  const unsigned char *bytes = static_cast<const unsigned char *>(data);
+  for (size_t i = 0; i < size; ++i)
+  {
+    hash ^= bytes[i];
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+/// Copies all non transparent pixels of a row.
+static void blitRow(SoftwareRenderer::Pixel *dst,
+                    const SoftwareRenderer::Pixel *src, int count)
+{
+  int i{0};
+#if defined(SOFTWARE_RENDERER_SSE2)
+  // 4 pixels at once: transparent source pixels select the destination
+  const __m128i alphaMask = _mm_set1_epi32(static_cast<int>(0xFF000000));
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    __m128i d = _mm_loadu_si128(reinterpret_cast<__m128i *>(dst + i));
+    __m128i transparent =
+        _mm_cmpeq_epi32(_mm_and_si128(s, alphaMask), zero);
+    __m128i result = _mm_or_si128(_mm_and_si128(transparent, d),
+                                  _mm_andnot_si128(transparent, s));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), result);
+  }
+#endif
+  for (; i < count; ++i)
+  {
+    if (src[i] & 0xFF000000)
+      dst[i] = src[i];
+  }
+}
+
+static void fillRow(SoftwareRenderer::Pixel *dst, SoftwareRenderer::Pixel color,
+                    int count)
+{
+  int i{0};
+#if defined(SOFTWARE_RENDERER_SSE2)
+  const __m128i c = _mm_set1_epi32(static_cast<int>(color));
+  for (; i + 4 <= count; i += 4)
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), c);
+#endif
+  for (; i < count; ++i)
+    dst[i] = color;
+}
+
+SoftwareRenderer::SoftwareRenderer()
+    : _atlasStorage(new Pixel[ATLAS_SIZE + 16]()),
+      _textArena(TEXT_ARENA_BYTES),
+      _framebuffer(Engine::CanvasWidth * Engine::CanvasHeight, CLEAR_COLOR)
+{
+  // a frame may add texts beyond the limit before the cache is cleared
+  _textRuns.reserve(2 * MAX_CACHED_TEXTS);
+
+  // 16 spare pixels to move the atlas to the next 64 byte boundary
+  std::uintptr_t address =
+      reinterpret_cast<std::uintptr_t>(_atlasStorage.get());
+  _atlas = _atlasStorage.get() + ((64 - address % 64) % 64) / sizeof(Pixel);
+}
+
+SoftwareRenderer::Pixel *SoftwareRenderer::getSpriteImage(int index) const
+{
+  return _atlas + index * SPRITE_SLOT;
+}
+
+SoftwareRenderer::Pixel *SoftwareRenderer::getGlyphImage(int index) const
+{
+  return _atlas + SPRITE_COUNT * SPRITE_SLOT + index * GLYPH_SLOT;
+}
+
+void SoftwareRenderer::setSpriteImage(Engine::Sprite sprite,
+                                      const Pixel *pixels)
+{
+  BuildTimer timer{_atlasBuildSeconds};
+  memcpy(getSpriteImage(spriteIndex(sprite)), pixels,
+         Engine::SpriteSize * Engine::SpriteSize * sizeof(Pixel));
+  // all sprites might look different now
+  _firstFrame = true;
+}
+
+void SoftwareRenderer::setGlyphImage(char c, const Pixel *pixels)
+{
+  unsigned char index = static_cast<unsigned char>(c);
+  if (index >= GLYPH_COUNT)
+    return;
+
+  BuildTimer timer{_atlasBuildSeconds};
+  memcpy(getGlyphImage(index), pixels,
+         Engine::FontWidth * Engine::FontRowHeight * sizeof(Pixel));
+  _hasGlyph[index] = true;
+  _textRunsStale = true;
+  _firstFrame = true;
+}
+
+void SoftwareRenderer::prepareTexts(
+    std::initializer_list<const char *> messages)
+{
+  // the glyphs are usually not set yet, see beginFrame
+  _preparedTexts.insert(_preparedTexts.end(), messages.begin(),
+                        messages.end());
+  _preparedTextsMissing = true;
+}
+
+/// Orders text runs by their text, like std::string::compare.
+static int compareText(const char *text, size_t length, const char *message,
+                       size_t messageLength)
+{
+  int result = memcmp(text, message, std::min(length, messageLength));
+  if (result != 0)
+    return result;
+  return length < messageLength ? -1 : (length > messageLength ? 1 : 0);
+}
+
+void SoftwareRenderer::beginFrame()
+{
+  _commands.clear();
+  _drawn.clear();
+
+  // no draw command references a text run at this point, so the cache can
+  // safely be changed. Half of the arena is kept free for the texts of the
+  // next frame, so they do not overflow to the heap.
+  if (_textRuns.size() > MAX_CACHED_TEXTS ||
+      _textArena.getUsed() > _textArena.getCapacity() / 2)
+  {
+    _textRuns.clear();
+    _textArena.reset();
+    _preparedTextsMissing = !_preparedTexts.empty();
+  }
+  else if (_textRunsStale)
+  {
+    BuildTimer timer{_atlasBuildSeconds};
+    for (TextRun *run : _textRuns)
+      rasterize(*run);
+  }
+  _textRunsStale = false;
+
+  if (_preparedTextsMissing)
+  {
+    BuildTimer timer{_atlasBuildSeconds};
+    for (const char *message : _preparedTexts)
+      getTextRun(message, strlen(message));
+    _preparedTextsMissing = false;
+  }
+}
+
+const SoftwareRenderer::TextRun &
+SoftwareRenderer::getTextRun(const char *message, size_t length)
+{
+  auto it = std::lower_bound(
+      _textRuns.begin(), _textRuns.end(), message,
+      [length](const TextRun *run, const char *m) {
+        return compareText(run->text, run->length, m, length) < 0;
+      });
+  if (it != _textRuns.end() &&
+      compareText((*it)->text, (*it)->length, message, length) == 0)
+    return **it;
+
+  char *text = static_cast<char *>(_textArena.allocate(length, 1));
+  memcpy(text, message, length);
+  const int width = static_cast<int>(length) * Engine::FontWidth;
+  Pixel *pixels = static_cast<Pixel *>(_textArena.allocate(
+      width * Engine::FontRowHeight * sizeof(Pixel), alignof(Pixel)));
+  TextRun *run = static_cast<TextRun *>(
+      _textArena.allocate(sizeof(TextRun), alignof(TextRun)));
+  *run = {text, static_cast<int>(length), width, pixels};
+  rasterize(*run);
+  _textRuns.insert(it, run);
+  return *run;
+}
+
+void SoftwareRenderer::rasterize(TextRun &run) const
+{
+  std::fill(run.pixels, run.pixels + run.width * Engine::FontRowHeight, 0);
+
+  for (int i = 0; i < run.length; ++i)
+  {
+    unsigned char c = static_cast<unsigned char>(run.text[i]);
+    if (c >= GLYPH_COUNT || !_hasGlyph[c])
+      continue;
+
+    const Pixel *glyph = getGlyphImage(c);
+    for (int row = 0; row < Engine::FontRowHeight; ++row)
+    {
+      memcpy(run.pixels + row * run.width + i * Engine::FontWidth,
+             glyph + row * Engine::FontWidth,
+             Engine::FontWidth * sizeof(Pixel));
+    }
+  }
+}
+
+void SoftwareRenderer::record(COMMAND type, int sprite, int x, int y,
+                              const TextRun *run, int width, int height,
+                              std::uint64_t key)
+{
+  PixelRect rect =
+      PixelRect{x, y, x + width, y + height}.clippedTo(CANVAS_RECT);
+  if (rect.isEmpty())
+    return;
+
+  _commands.push_back(
+      {type, static_cast<std::uint8_t>(sprite), x, y, run, rect});
+  _drawn.push_back({key, rect});
+}
+
+void SoftwareRenderer::drawSprite(Engine::Sprite sprite, int x, int y)
+{
+  int index = spriteIndex(sprite);
+  int values[] = {int(COMMAND::SPRITE), index, x, y};
+  record(COMMAND::SPRITE, index, x, y, nullptr, Engine::SpriteSize,
+         Engine::SpriteSize, hashBytes(values, sizeof(values)));
+}
+
+void SoftwareRenderer::drawText(const char *message, int x, int y)
+{
+  size_t length = strlen(message);
+  const TextRun &run = getTextRun(message, length);
+
+  int values[] = {int(COMMAND::TEXT), x, y};
+  record(COMMAND::TEXT, 0, x, y, &run, run.width, Engine::FontRowHeight,
+         hashBytes(values, sizeof(values), hashBytes(message, length)));
+}
+
+const std::vector<PixelRect> &SoftwareRenderer::present()
+{
+  collectDirtyRects();
+
+  _stats = {};
+  for (const PixelRect &region : _dirtyRects)
+  {
+    redraw(region);
+    _stats.redrawnPixels += region.area();
+  }
+  _stats.dirtyRects = static_cast<int>(_dirtyRects.size());
+
+  _previousDrawn.swap(_drawn);
+  return _dirtyRects;
+}
+
+void SoftwareRenderer::collectDirtyRects()
+{
+  _dirtyRects.clear();
+
+  if (_firstFrame)
+  {
+    _firstFrame = false;
+    _dirtyRects.push_back(CANVAS_RECT);
+    return;
+  }
+
+  // Draw calls that exist in both frames did not change. All others either
+  // appeared or vanished, both need their region to be redrawn.
+  std::sort(_drawn.begin(), _drawn.end());
+  std::sort(_previousDrawn.begin(), _previousDrawn.end());
+  auto cur = _drawn.begin();
+  auto prev = _previousDrawn.begin();
+  while (cur != _drawn.end() || prev != _previousDrawn.end())
+  {
+    if (prev == _previousDrawn.end() ||
+        (cur != _drawn.end() && cur->key < prev->key))
+    {
+      _dirtyRects.push_back((cur++)->rect);
+    }
+    else if (cur == _drawn.end() || prev->key < cur->key)
+    {
+      _dirtyRects.push_back((prev++)->rect);
+    }
+    else
+    {
+      ++cur;
+      ++prev;
+    }
+  }
+
+  // merge overlapping rectangles, so no pixel is redrawn twice
+  bool merged{true};
+  while (merged)
+  {
+    merged = false;
+    for (size_t i = 0; i < _dirtyRects.size(); ++i)
+    {
+      for (size_t j = i + 1; j < _dirtyRects.size();)
+      {
+        if (_dirtyRects[i].intersectsWith(_dirtyRects[j]))
+        {
+          _dirtyRects[i].merge(_dirtyRects[j]);
+          _dirtyRects[j] = _dirtyRects.back();
+          _dirtyRects.pop_back();
+          merged = true;
+        }
+        else
+        {
+          ++j;
+        }
+      }
+    }
+  }
+
+  // if most of the canvas changed, one full redraw is cheaper
+  int dirtyArea{0};
+  for (const PixelRect &r : _dirtyRects)
+    dirtyArea += r.area();
+  if (dirtyArea > CANVAS_RECT.area() / 2)
+  {
+    _dirtyRects.clear();
+    _dirtyRects.push_back(CANVAS_RECT);
+  }
+}
+
+void SoftwareRenderer::redraw(const PixelRect &region)
+{
+  fill(region, CLEAR_COLOR);
+
+  // commands are executed in the order they were issued, so overlapping
+  // images keep their stacking
+  for (const DrawCommand &cmd : _commands)
+  {
+    if (cmd.rect.intersectsWith(region))
+      execute(cmd, region);
+  }
+}
+
+void SoftwareRenderer::execute(const DrawCommand &cmd, const PixelRect &clip)
+{
+  if (cmd.type == COMMAND::SPRITE)
+  {
+    blit(getSpriteImage(cmd.sprite), Engine::SpriteSize, Engine::SpriteSize,
+         cmd.x, cmd.y, clip);
+  }
+  else
+  {
+    blit(cmd.run->pixels, cmd.run->width, Engine::FontRowHeight, cmd.x,
+         cmd.y, clip);
+  }
+}
+
+void SoftwareRenderer::blit(const Pixel *image, int width, int height, int x,
+                            int y, const PixelRect &clip)
+{
+  PixelRect target = PixelRect{x, y, x + width, y + height}.clippedTo(clip);
+  if (target.isEmpty())
+    return;
+
+  int count = target.right - target.left;
+  for (int row = target.top; row < target.bottom; ++row)
+  {
+    const Pixel *src =
+        image + (row - y) * width + (target.left - x);
+    Pixel *dst = _framebuffer.data() + row * getStride() + target.left;
+    blitRow(dst, src, count);
+  }
+}
+
+void SoftwareRenderer::fill(const PixelRect &region, Pixel color)
+{
+  int count = region.right - region.left;
+  for (int row = region.top; row < region.bottom; ++row)
+    fillRow(_framebuffer.data() + row * getStride() + region.left, color,
+            count);
+}
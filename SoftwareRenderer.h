@@ -0,0 +1,185 @@
+#ifndef SOFTWARE_RENDERER_H__
+#define SOFTWARE_RENDERER_H__
+
+#include <array>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <vector>
+
+#include "Engine.h"
+#include "FrameArena.h"
+
+/// Pixel rectangle on the canvas. Right and bottom are exclusive.
+struct PixelRect
+{
+  int left{0};
+  int top{0};
+  int right{0};
+  int bottom{0};
+
+  bool isEmpty() const { return left >= right || top >= bottom; }
+
+  int area() const { return isEmpty() ? 0 : (right - left) * (bottom - top); }
+
+  bool intersectsWith(const PixelRect &o) const
+  {
+    return left < o.right && o.left < right && top < o.bottom &&
+           o.top < bottom;
+  }
+
+  /// Returns the overlapping part of both rectangles.
+  PixelRect clippedTo(const PixelRect &o) const;
+
+  /// Grows the rectangle so it also encloses the given one.
+  void merge(const PixelRect &o);
+};
+
+/// Rasterizes sprites and text into an in-memory framebuffer, for hosts
+/// without SDL2 or a GPU. The renderer records the draw calls of a frame and
+/// compares them with those of the previous frame. Only regions where
+/// something appeared, disappeared or moved are cleared and redrawn.
+///
+/// All sprite and glyph images live in one cache aligned atlas. Texts are
+/// rasterized once into a cached run and then drawn with a single blit. The
+/// runs are allocated from an arena, once it has grown to the texts of the
+/// game, drawing does not touch the heap.
+class SoftwareRenderer
+{
+public:
+  /// 32 bit pixel, 0xAARRGGBB. Pixels with an alpha of 0 are transparent.
+  using Pixel = std::uint32_t;
+
+  static const int SPRITE_COUNT{5};
+  static const int GLYPH_COUNT{128};
+  /// The text run cache is cleared once it holds more texts (e.g. scores)
+  /// or half of its arena is used.
+  static const int MAX_CACHED_TEXTS{256};
+  /// Initial size of the arena of the text runs.
+  static const int TEXT_ARENA_BYTES{256 * 1024};
+  static const Pixel CLEAR_COLOR{0xFF000000};
+
+  /// Statistics of the last presented frame.
+  struct FrameStats
+  {
+    int dirtyRects{0};
+    int redrawnPixels{0};
+  };
+
+  SoftwareRenderer();
+
+  /// Sets the image of a sprite. Expects Engine::SpriteSize *
+  /// Engine::SpriteSize pixels in rows.
+  void setSpriteImage(Engine::Sprite sprite, const Pixel *pixels);
+
+  /// Sets the image of a character. Expects Engine::FontWidth *
+  /// Engine::FontRowHeight pixels in rows.
+  void setGlyphImage(char c, const Pixel *pixels);
+
+  /// Rasterizes texts ahead of time, e.g. static messages of the hud. They
+  /// are rasterized at the next beginFrame, when the host has set the glyph
+  /// images, and again whenever the cache was cleared. The messages are not
+  /// copied and have to stay valid, like string literals.
+  void prepareTexts(std::initializer_list<const char *> messages);
+
+  /// Time spent filling the atlas and rasterizing text runs, in seconds.
+  double getAtlasBuildSeconds() const { return _atlasBuildSeconds; }
+
+  /// Starts recording the draw calls of a new frame.
+  void beginFrame();
+
+  void drawSprite(Engine::Sprite sprite, int x, int y);
+
+  void drawText(const char *message, int x, int y);
+
+  /// Redraws all regions that changed since the last frame. The returned
+  /// rectangles are the regions that need to be presented.
+  const std::vector<PixelRect> &present();
+
+  const Pixel *getPixels() const { return _framebuffer.data(); }
+
+  /// Number of pixels per framebuffer row.
+  int getStride() const { return Engine::CanvasWidth; }
+
+  const FrameStats &getFrameStats() const { return _stats; }
+
+private:
+  enum class COMMAND : std::uint8_t
+  {
+    SPRITE,
+    TEXT
+  };
+
+  /// Pre-rasterized text, FontRowHeight rows of width pixels. The text and
+  /// the pixels are allocated from the text arena.
+  struct TextRun
+  {
+    const char *text;
+    int length;
+    int width;
+    Pixel *pixels;
+  };
+
+  struct DrawCommand
+  {
+    COMMAND type;
+    std::uint8_t sprite;
+    int x;
+    int y;
+    const TextRun *run;
+    PixelRect rect;
+  };
+
+  /// Region covered by a draw call. The key identifies the call across
+  /// frames (type, image or message and position).
+  struct KeyedRect
+  {
+    std::uint64_t key;
+    PixelRect rect;
+
+    bool operator<(const KeyedRect &o) const { return key < o.key; }
+  };
+
+  void record(COMMAND type, int sprite, int x, int y, const TextRun *run,
+              int width, int height, std::uint64_t key);
+  const TextRun &getTextRun(const char *message, size_t length);
+  void rasterize(TextRun &run) const;
+  void collectDirtyRects();
+  void redraw(const PixelRect &region);
+  void execute(const DrawCommand &cmd, const PixelRect &clip);
+  void blit(const Pixel *image, int width, int height, int x, int y,
+            const PixelRect &clip);
+  void fill(const PixelRect &region, Pixel color);
+
+  Pixel *getSpriteImage(int index) const;
+  Pixel *getGlyphImage(int index) const;
+
+  /// Sprites followed by glyphs, every image starts on a cache line.
+  std::unique_ptr<Pixel[]> _atlasStorage;
+  Pixel *_atlas{nullptr};
+  std::array<bool, GLYPH_COUNT> _hasGlyph{};
+  double _atlasBuildSeconds{0.0};
+
+  /// Text runs sorted by their text. The runs themselves live in the arena,
+  /// so those referenced by the draw commands stay in place when new texts
+  /// are added. Both are only cleared between frames.
+  FrameArena _textArena;
+  std::vector<TextRun *> _textRuns;
+  bool _textRunsStale{false};
+  /// Texts of prepareTexts, rasterized at the next beginFrame if missing
+  std::vector<const char *> _preparedTexts;
+  bool _preparedTextsMissing{false};
+
+  std::vector<Pixel> _framebuffer;
+
+  std::vector<DrawCommand> _commands;
+
+  std::vector<KeyedRect> _drawn;
+  std::vector<KeyedRect> _previousDrawn;
+  std::vector<PixelRect> _dirtyRects;
+
+  FrameStats _stats;
+  bool _firstFrame{true};
+};
+
+#endif // SOFTWARE_RENDERER_H__
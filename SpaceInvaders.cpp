@@ -1,9 +1,141 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "AllocationCounter.h"
 #include "GameEngine.h"
+#include "SoakTest.h"
+#include "SpectatorViewer.h"
+#include "StressTest.h"
 
 void EngineMain()
 {
+	// e.g. SPACEINVADERS_SPECTATE=/tmp/spaceinvaders.sock shows the game
+	// another instance streams there, instead of playing
+	if (const char *path = std::getenv("SPACEINVADERS_SPECTATE"))
+	{
+		SpectatorViewer viewer{path};
+		while (viewer.startFrame())
+		{
+			viewer.receive();
+			viewer.draw();
+		}
+		return;
+	}
+
+	// e.g. SPACEINVADERS_STRESS=2 measures the update with one formation,
+	// 10^3 to 10^6 objects and the formations that fill the L2 cache, for 2
+	// seconds each, instead of playing
+	if (const char *seconds = std::getenv("SPACEINVADERS_STRESS"))
+	{
+		StressTest::Footprint f = StressTest::getFootprint();
+		printf("%d bytes per object, %d bytes per scene (%d cache lines), "
+		       "%d bytes per game with timers and random generator, "
+		       "%d bytes per formation\n",
+		       f.objectBytes, f.sceneBytes, (f.sceneBytes + 63) / 64,
+		       f.gameBytes, f.formationBytes);
+		printf("%ld KiB L2 cache holds %ld games or %ld formations\n",
+		       f.l2Bytes / 1024, f.gamesPerL2, f.formationsPerL2);
+
+		StressTest::ConfigComparison c = StressTest::compareConfigs(
+		    static_cast<int>(f.gamesPerL2), std::atof(seconds));
+		printf("%d games, %d ticks, %d rounds: %.1f ns per game tick with "
+		       "Config\n",
+		       c.games, c.ticks, StressTest::ConfigComparison::ROUNDS,
+		       c.specializedSeconds * 1e9);
+		for (const StressTest::ConfigVariant &v : c.variants)
+		{
+			printf("  %-16s %7.1f ns %+6.1f%% (rounds %+.1f%% to %+.1f%%)%s\n",
+			       v.name, v.seconds * 1e9, v.change, v.minChange,
+			       v.maxChange, v.sameGames ? "" : ", other games");
+		}
+
+		StressTest::MetricsCost m = StressTest::measureMetrics(
+		    std::atof(seconds));
+		printf("metrics: %.1f ns per add, %.1f ns per set, %.1f ns per scoped "
+		       "timer\n",
+		       m.addSeconds * 1e9, m.setSeconds * 1e9, m.timerSeconds * 1e9);
+
+		// the rows are rounded down to whole formations, the first is one
+		std::vector<int> objectCounts{StressTest::OBJECTS_PER_FORMATION, 1000,
+		                              10000, 100000, 1000000};
+		objectCounts.push_back(static_cast<int>(
+		    f.formationsPerL2 * StressTest::OBJECTS_PER_FORMATION));
+		std::sort(objectCounts.begin(), objectCounts.end());
+
+		StressTest stress;
+		printf("%8s %10s %10s %10s %10s %10s %10s %10s %10s %10s %8s\n",
+		       "objects", "formations", "KiB", "alive", "ticks/s", "input us",
+		       "enemies us", "bombs us", "rockets us", "ns/object", "restarts");
+		for (int objects : objectCounts)
+		{
+			StressTest::Result r = stress.run(objects, std::atof(seconds));
+			double tickSeconds = r.inputSeconds + r.enemiesSeconds +
+			                     r.bombsSeconds + r.rocketsSeconds;
+			printf("%8d %10d %10ld %10.0f %10.0f %10.1f %10.1f %10.1f %10.1f "
+			       "%10.1f %8d\n",
+			       r.capacity, r.formations,
+			       static_cast<long>(r.formations) * f.formationBytes / 1024,
+			       r.aliveObjects, r.ticksPerSecond, r.inputSeconds * 1e6,
+			       r.enemiesSeconds * 1e6, r.bombsSeconds * 1e6,
+			       r.rocketsSeconds * 1e6, tickSeconds / r.aliveObjects * 1e9,
+			       r.restarts);
+		}
+		return;
+	}
+
+	// e.g. SPACEINVADERS_SOAK=100000000 compares the game with its reference
+	// model for 10^8 ticks, 0 runs until they diverge, instead of playing
+	if (const char *ticks = std::getenv("SPACEINVADERS_SOAK"))
+	{
+		const char *seed = std::getenv("SPACEINVADERS_SOAK_SEED");
+		SoakTest soak{seed ? static_cast<unsigned>(std::atoll(seed)) : 1u};
+		SoakTest::Result r = soak.run(std::atoll(ticks), 10.0, stdout);
+		printf("%s after %lld ticks and %d restarts\n",
+		       r.diverged ? "diverged" : "no divergence",
+		       static_cast<long long>(r.ticks), r.restarts);
+		if (r.diverged)
+			std::exit(EXIT_FAILURE);
+		return;
+	}
+
 	GameEngine engine;
 
+#if defined(SOFTWARE_RENDERER)
+	// e.g. SPACEINVADERS_CAPTURE=run.y4m or SPACEINVADERS_CAPTURE=run.png
+	if (const char *path = std::getenv("SPACEINVADERS_CAPTURE"))
+		engine.startCapture(path);
+#endif
+
+	// e.g. SPACEINVADERS_METRICS=metrics.prom or
+	// SPACEINVADERS_METRICS=unix:/run/spaceinvaders.sock
+	if (const char *target = std::getenv("SPACEINVADERS_METRICS"))
+		engine.getMetrics().startExporter(target, Config::METRICS_EXPORT_SECONDS);
+
+	// e.g. SPACEINVADERS_BOT=4 lets a bot play, looking ahead on 4 threads
+	if (const char *threads = std::getenv("SPACEINVADERS_BOT"))
+		engine.startBot(std::max(std::atoi(threads), 1));
+
+	// e.g. SPACEINVADERS_SPECTATORS=/tmp/spaceinvaders.sock
+	if (const char *path = std::getenv("SPACEINVADERS_SPECTATORS"))
+		engine.startSpectatorStream(path);
+
+	// e.g. SPACEINVADERS_ALLOCATION_CHECK=3600 fails if any of 3600 frames
+	// after the warm-up allocates from the heap. Needs a build with
+	// -DCOUNT_ALLOCATIONS, SPACEINVADERS_BOT lets it run unattended.
+	int framesToCheck{0};
+	std::int64_t allocationsBefore{-1};
+	if (const char *frames = std::getenv("SPACEINVADERS_ALLOCATION_CHECK"))
+	{
+		if (!AllocationCounter::isCounting())
+		{
+			printf("the allocation check needs -DCOUNT_ALLOCATIONS\n");
+			std::exit(EXIT_FAILURE);
+		}
+		framesToCheck = std::max(std::atoi(frames), 1);
+	}
+
 	double end;
 	double start = engine.getStopwatchElapsedSeconds();
 
@@ -13,6 +145,20 @@ void EngineMain()
 		engine.update();
 		engine.draw();
 
+		if (framesToCheck > 0)
+		{
+			if (allocationsBefore >= 0)
+			{
+				if (--framesToCheck == 0)
+					break;
+			}
+			else if (engine.getStopwatchElapsedSeconds() - start >=
+			         Config::ALLOCATION_CHECK_WARMUP_SECONDS)
+			{
+				allocationsBefore = AllocationCounter::getCount();
+			}
+		}
+
 		// I am not up to date with the ways how game loops today deal to
 		// limit fps (60fps). Sleeps are a possible way to slow down the
 		// execution or rendering, but e.g. on Windows for example the scheduler has
@@ -23,4 +169,14 @@ void EngineMain()
     usleep(time to limit to 60 or 30 fps);
     */
 	}
+
+	if (allocationsBefore >= 0)
+	{
+		std::int64_t allocations =
+		    AllocationCounter::getCount() - allocationsBefore;
+		printf("%lld heap allocations after the warm-up\n",
+		       static_cast<long long>(allocations));
+		if (allocations > 0)
+			std::exit(EXIT_FAILURE);
+	}
 }
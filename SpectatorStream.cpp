@@ -0,0 +1,463 @@
+#include <algorithm>
+#include <cmath>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#define SPECTATOR_UNIX_SOCKET
+#endif
+
+#include "SpectatorStream.h"
+
+static const float FIXED_SCALE = 1 << Config::SPECTATOR_POSITION_FRACTION_BITS;
+
+/// Coordinates are sent as fixed point values.
+static int toUnits(float value)
+{
+  return static_cast<int>(std::lround(value * FIXED_SCALE));
+}
+
+static float fromUnits(int units) { return units / FIXED_SCALE; }
+
+/// Positions a viewer can't tell apart.
+static bool isSameUnits(Position a, Position b)
+{
+  return toUnits(a._x) == toUnits(b._x) && toUnits(a._y) == toUnits(b._y);
+}
+
+static unsigned fieldBit(SPECTATOR_FIELD field)
+{
+  return 1u << static_cast<int>(field);
+}
+
+/// Appends bytes and varints to a message buffer.
+class MessageWriter
+{
+public:
+  explicit MessageWriter(std::uint8_t *out) : _out(out) {}
+
+  void byte(std::uint8_t value) { _out[_size++] = value; }
+
+  void varint(std::uint64_t value)
+  {
+    while (value >= 0x80)
+    {
+      byte(static_cast<std::uint8_t>(value | 0x80));
+      value >>= 7;
+    }
+    byte(static_cast<std::uint8_t>(value));
+  }
+
+  /// Zigzag encoded, small negative values stay short.
+  void signedVarint(std::int64_t value)
+  {
+    varint((static_cast<std::uint64_t>(value) << 1) ^
+           static_cast<std::uint64_t>(value >> 63));
+  }
+
+  int size() const { return _size; }
+
+private:
+  std::uint8_t *_out;
+  int _size{0};
+};
+
+/// Reads what MessageWriter wrote. Reading past the end fails the reader
+/// instead of the caller checking every value.
+class MessageReader
+{
+public:
+  MessageReader(const std::uint8_t *data, int size) : _data(data), _size(size)
+  {
+  }
+
+  std::uint8_t byte()
+  {
+    if (_pos >= _size)
+    {
+      _ok = false;
+      return 0;
+    }
+    return _data[_pos++];
+  }
+
+  std::uint64_t varint()
+  {
+    std::uint64_t value{0};
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+      std::uint8_t b = byte();
+      value |= static_cast<std::uint64_t>(b & 0x7f) << shift;
+      if (!(b & 0x80))
+        return value;
+    }
+    _ok = false;
+    return 0;
+  }
+
+  std::int64_t signedVarint()
+  {
+    std::uint64_t value = varint();
+    return static_cast<std::int64_t>(value >> 1) ^
+           -static_cast<std::int64_t>(value & 1);
+  }
+
+  /// All values were read and nothing is left.
+  bool isComplete() const { return _ok && _pos == _size; }
+
+  bool isOk() const { return _ok; }
+
+private:
+  const std::uint8_t *_data;
+  int _size;
+  int _pos{0};
+  bool _ok{true};
+};
+
+/// Objects that are alive but weren't, or are somewhere else.
+template <typename Pool>
+static std::uint64_t movedSlots(const Pool &pool, const Pool &base)
+{
+  std::uint64_t mask{0};
+  for (int i : pool.alive())
+  {
+    Position pos = pool[i].getPosition();
+    Position basePos = base[i].getPosition();
+    if (!base.isAlive(i) || !isSameUnits(pos, basePos))
+      mask |= std::uint64_t{1} << i;
+  }
+  return mask;
+}
+
+template <typename Pool>
+static bool samePool(const Pool &a, const Pool &b)
+{
+  return a.aliveMask() == b.aliveMask() && movedSlots(a, b) == 0;
+}
+
+template <typename Pool>
+static void writePool(MessageWriter &w, const Pool &pool, const Pool &base)
+{
+  w.varint(base.aliveMask() & ~pool.aliveMask());
+  std::uint64_t moved = movedSlots(pool, base);
+  w.varint(moved);
+  for (int i : AliveIndices{moved})
+  {
+    Position pos = pool[i].getPosition();
+    w.signedVarint(toUnits(pos._x));
+    w.signedVarint(toUnits(pos._y));
+  }
+}
+
+template <typename Pool>
+static bool readPool(MessageReader &r, Pool &pool)
+{
+  const std::uint64_t outside =
+      Pool::size() == 64 ? 0 : ~std::uint64_t{0} << Pool::size();
+
+  std::uint64_t despawned = r.varint();
+  if (despawned & outside)
+    return false;
+  for (int i : AliveIndices{despawned})
+    pool.destroy(i);
+
+  std::uint64_t moved = r.varint();
+  if (moved & outside)
+    return false;
+  for (int i : AliveIndices{moved})
+  {
+    float x = fromUnits(static_cast<int>(r.signedVarint()));
+    float y = fromUnits(static_cast<int>(r.signedVarint()));
+    pool.spawn(i, {x, y});
+  }
+  return r.isOk();
+}
+
+template <typename Cfg>
+const int SpectatorState<Cfg>::MAX_MESSAGE_SIZE;
+
+template <typename Cfg>
+void SpectatorState<Cfg>::capture(
+    GAMESTATE state, const Simulation &sim,
+    const typename Simulation::EnemyPool &layout)
+{
+  gamestate = state;
+  score = sim.getHighscore().getCurrentScore();
+  highscore = sim.getHighscore().getHighscore();
+  level = sim.getLevel();
+  player = sim.getPlayer();
+
+  // all alive enemies travel together, any of them gives the offset
+  const auto &enemies = sim.getEnemies();
+  enemiesAlive = enemies.aliveMask();
+  if (enemies.any())
+  {
+    int i = countTrailingZeros(enemiesAlive);
+    Position pos = enemies[i].getPosition();
+    Position origin = layout[i].getPosition();
+    enemyOffsetX = toUnits(pos._x) - toUnits(origin._x);
+    enemyOffsetY = toUnits(pos._y) - toUnits(origin._y);
+  }
+
+  rockets = sim.getRockets();
+  bombs = sim.getBombs();
+}
+
+template <typename Cfg>
+void SpectatorState<Cfg>::advance(double seconds)
+{
+  // the simulation only moves objects while the game is played
+  if (gamestate != GAMESTATE::PLAY)
+    return;
+
+  for (int i : rockets.alive())
+  {
+    Rocket &r = rockets[i];
+    r.setPositionY(r.getPosition()._y - Simulation::ROCKET_STEP);
+  }
+  for (int i : bombs.alive())
+  {
+    Bomb &b = bombs[i];
+    b.setPositionY(b.getPosition()._y + Simulation::BOMB_SPEED * seconds);
+  }
+}
+
+template <typename Cfg>
+int SpectatorState<Cfg>::encode(const SpectatorState &from,
+                                SPECTATOR_MESSAGE type, int tickMicros,
+                                std::uint8_t *out) const
+{
+  const SpectatorState empty{};
+  const SpectatorState &base =
+      type == SPECTATOR_MESSAGE::KEYFRAME ? empty : from;
+
+  unsigned fields{0};
+  if (gamestate != base.gamestate)
+    fields |= fieldBit(SPECTATOR_FIELD::STATE);
+  if (score != base.score)
+    fields |= fieldBit(SPECTATOR_FIELD::SCORE);
+  if (highscore != base.highscore)
+    fields |= fieldBit(SPECTATOR_FIELD::HIGHSCORE);
+  if (level != base.level)
+    fields |= fieldBit(SPECTATOR_FIELD::LEVEL);
+  Position pos = player.getPosition();
+  Position basePos = base.player.getPosition();
+  if (!isSameUnits(pos, basePos) ||
+      player.getHealth() != base.player.getHealth())
+    fields |= fieldBit(SPECTATOR_FIELD::PLAYER);
+  if (enemiesAlive != base.enemiesAlive)
+    fields |= fieldBit(SPECTATOR_FIELD::ENEMIES);
+  if (enemyOffsetX != base.enemyOffsetX || enemyOffsetY != base.enemyOffsetY)
+    fields |= fieldBit(SPECTATOR_FIELD::ENEMY_OFFSET);
+  if (!samePool(rockets, base.rockets))
+    fields |= fieldBit(SPECTATOR_FIELD::ROCKETS);
+  if (!samePool(bombs, base.bombs))
+    fields |= fieldBit(SPECTATOR_FIELD::BOMBS);
+
+  MessageWriter w{out};
+  w.byte(static_cast<std::uint8_t>(type));
+  if (type == SPECTATOR_MESSAGE::DELTA)
+    w.varint(static_cast<std::uint64_t>(tickMicros));
+  w.varint(fields);
+
+  if (fields & fieldBit(SPECTATOR_FIELD::STATE))
+    w.varint(static_cast<std::uint64_t>(gamestate));
+  if (fields & fieldBit(SPECTATOR_FIELD::SCORE))
+    w.signedVarint(score);
+  if (fields & fieldBit(SPECTATOR_FIELD::HIGHSCORE))
+    w.signedVarint(highscore);
+  if (fields & fieldBit(SPECTATOR_FIELD::LEVEL))
+    w.signedVarint(level);
+  if (fields & fieldBit(SPECTATOR_FIELD::PLAYER))
+  {
+    w.signedVarint(toUnits(pos._x));
+    w.signedVarint(toUnits(pos._y));
+    w.signedVarint(player.getHealth());
+  }
+  if (fields & fieldBit(SPECTATOR_FIELD::ENEMIES))
+    w.varint(enemiesAlive ^ base.enemiesAlive);
+  if (fields & fieldBit(SPECTATOR_FIELD::ENEMY_OFFSET))
+  {
+    w.signedVarint(enemyOffsetX - base.enemyOffsetX);
+    w.signedVarint(enemyOffsetY - base.enemyOffsetY);
+  }
+  if (fields & fieldBit(SPECTATOR_FIELD::ROCKETS))
+    writePool(w, rockets, base.rockets);
+  if (fields & fieldBit(SPECTATOR_FIELD::BOMBS))
+    writePool(w, bombs, base.bombs);
+
+  return w.size();
+}
+
+template <typename Cfg>
+bool SpectatorState<Cfg>::apply(const std::uint8_t *data, int size)
+{
+  MessageReader r{data, size};
+  const std::uint8_t type = r.byte();
+  if (type == static_cast<std::uint8_t>(SPECTATOR_MESSAGE::KEYFRAME))
+  {
+    *this = SpectatorState{};
+  }
+  else if (type == static_cast<std::uint8_t>(SPECTATOR_MESSAGE::DELTA))
+  {
+    if (!synced)
+      return true;
+    advance(static_cast<double>(r.varint()) * 1e-6);
+  }
+  else
+  {
+    synced = false;
+    return false;
+  }
+
+  const std::uint64_t fields = r.varint();
+  bool valid = fields < (1u << static_cast<int>(SPECTATOR_FIELD::COUNT));
+
+  if (fields & fieldBit(SPECTATOR_FIELD::STATE))
+  {
+    std::uint64_t state = r.varint();
+    valid = valid && state <= static_cast<std::uint64_t>(GAMESTATE::TRYAGAIN);
+    gamestate = static_cast<GAMESTATE>(state);
+  }
+  if (fields & fieldBit(SPECTATOR_FIELD::SCORE))
+    score = static_cast<int>(r.signedVarint());
+  if (fields & fieldBit(SPECTATOR_FIELD::HIGHSCORE))
+    highscore = static_cast<int>(r.signedVarint());
+  if (fields & fieldBit(SPECTATOR_FIELD::LEVEL))
+    level = static_cast<int>(r.signedVarint());
+  if (fields & fieldBit(SPECTATOR_FIELD::PLAYER))
+  {
+    float x = fromUnits(static_cast<int>(r.signedVarint()));
+    float y = fromUnits(static_cast<int>(r.signedVarint()));
+    player.setPosition({x, y});
+    player.setHealth(static_cast<int>(r.signedVarint()));
+  }
+  if (fields & fieldBit(SPECTATOR_FIELD::ENEMIES))
+  {
+    enemiesAlive ^= r.varint();
+    valid = valid && (Cfg::ENEMY_COUNT == 64 ||
+                      (enemiesAlive >> Cfg::ENEMY_COUNT) == 0);
+  }
+  if (fields & fieldBit(SPECTATOR_FIELD::ENEMY_OFFSET))
+  {
+    enemyOffsetX += static_cast<int>(r.signedVarint());
+    enemyOffsetY += static_cast<int>(r.signedVarint());
+  }
+  if (fields & fieldBit(SPECTATOR_FIELD::ROCKETS))
+    valid = valid && readPool(r, rockets);
+  if (fields & fieldBit(SPECTATOR_FIELD::BOMBS))
+    valid = valid && readPool(r, bombs);
+
+  synced = valid && r.isComplete();
+  return synced;
+}
+
+template <typename Cfg>
+Position SpectatorState<Cfg>::getEnemyPosition(
+    const typename Simulation::EnemyPool &layout, int i) const
+{
+  Position origin = layout[i].getPosition();
+  return {fromUnits(toUnits(origin._x) + enemyOffsetX),
+          fromUnits(toUnits(origin._y) + enemyOffsetY)};
+}
+
+template <typename Cfg>
+bool SpectatorState<Cfg>::operator==(const SpectatorState &o) const
+{
+  return gamestate == o.gamestate && score == o.score &&
+         highscore == o.highscore && level == o.level &&
+         isSameUnits(player.getPosition(), o.player.getPosition()) &&
+         player.getHealth() == o.player.getHealth() &&
+         enemiesAlive == o.enemiesAlive && enemyOffsetX == o.enemyOffsetX &&
+         enemyOffsetY == o.enemyOffsetY && samePool(rockets, o.rockets) &&
+         samePool(bombs, o.bombs);
+}
+
+template <typename Cfg>
+SpectatorPublisher<Cfg>::SpectatorPublisher(const std::string &path,
+                                            MetricsRegistry &metrics)
+    : _metrics(metrics), _path(path),
+      _layout(GameSimulation<Cfg>{}.getEnemies())
+{
+#if defined(SPECTATOR_UNIX_SOCKET)
+  _socket = socket(AF_UNIX, SOCK_DGRAM, 0);
+#endif
+}
+
+template <typename Cfg>
+SpectatorPublisher<Cfg>::~SpectatorPublisher()
+{
+#if defined(SPECTATOR_UNIX_SOCKET)
+  if (_socket >= 0)
+    close(_socket);
+#endif
+}
+
+template <typename Cfg>
+void SpectatorPublisher<Cfg>::publish(GAMESTATE state,
+                                      const GameSimulation<Cfg> &sim,
+                                      double seconds)
+{
+  ScopedMetricTimer timer{_metrics, METRIC::SPECTATOR_SECONDS};
+
+  _current.capture(state, sim, _layout);
+
+  SPECTATOR_MESSAGE type{SPECTATOR_MESSAGE::DELTA};
+  const int tickMicros =
+      std::max(0, static_cast<int>(std::lround(seconds * 1e6)));
+  SpectatorState<Cfg> viewer = _sent;
+  if (_keyframeDue || _ticksSinceKeyframe >= Cfg::SPECTATOR_KEYFRAME_TICKS)
+  {
+    type = SPECTATOR_MESSAGE::KEYFRAME;
+    _ticksSinceKeyframe = 0;
+  }
+  else
+  {
+    // the viewer moves its objects the same way before applying the delta
+    viewer.advance(tickMicros * 1e-6);
+    ++_ticksSinceKeyframe;
+  }
+
+  const int size = _current.encode(viewer, type, tickMicros, _message.data());
+  // positions are sent rounded, the state of the viewer is only known by
+  // applying the message the same way
+  _sent.apply(_message.data(), size);
+
+  if (send(size))
+  {
+    _keyframeDue = false;
+    _metrics.add(METRIC::SPECTATOR_MESSAGES);
+    _metrics.add(METRIC::SPECTATOR_BYTES, size);
+  }
+  else
+  {
+    _keyframeDue = true;
+    _metrics.add(METRIC::SPECTATOR_DROPPED_MESSAGES);
+  }
+}
+
+template <typename Cfg>
+bool SpectatorPublisher<Cfg>::send(int size)
+{
+#if defined(SPECTATOR_UNIX_SOCKET)
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if (_socket < 0 || _path.size() >= sizeof(address.sun_path))
+    return false;
+  _path.copy(address.sun_path, _path.size());
+
+  // no viewer or a full queue drops the message, the game never waits
+  return sendto(_socket, _message.data(), static_cast<size_t>(size),
+                MSG_DONTWAIT, reinterpret_cast<sockaddr *>(&address),
+                sizeof(address)) == size;
+#else
+  (void)size;
+  return false;
+#endif
+}
+
+template struct SpectatorState<Config>;
+template struct SpectatorState<HeadlessConfig>;
+template class SpectatorPublisher<Config>;
+template class SpectatorPublisher<HeadlessConfig>;
@@ -0,0 +1,140 @@
+#ifndef SPECTATOR_STREAM_H__
+#define SPECTATOR_STREAM_H__
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+#include "Config.h"
+#include "GameSimulation.h"
+#include "Metrics.h"
+
+/// Kind of a spectator message.
+enum class SPECTATOR_MESSAGE : std::uint8_t
+{
+  KEYFRAME = 1,
+  DELTA = 2
+};
+
+/// Fields a spectator message can carry, one bit each.
+enum class SPECTATOR_FIELD : int
+{
+  STATE,
+  SCORE,
+  HIGHSCORE,
+  LEVEL,
+  PLAYER,
+  ENEMIES,
+  ENEMY_OFFSET,
+  ROCKETS,
+  BOMBS,
+  COUNT
+};
+
+/// What a spectator sees of a game, and the encoding of its changes.
+///
+/// A message is the type, for deltas the time of the tick in microseconds,
+/// a mask of the fields that changed and the fields themselves, all numbers
+/// as LEB128 varints. Before a delta is applied, rockets and bombs are moved
+/// like the simulation moves them, only spawns, despawns and the rare
+/// rounding differences are sent. Enemies are the layout of a reset plus
+/// the offset of the formation and a mask of the alive ones, which is sent
+/// as the bits that flipped. A keyframe is a delta against the default
+/// state, so a viewer can join at any keyframe.
+template <typename Cfg = Config>
+struct SpectatorState
+{
+  using Simulation = GameSimulation<Cfg>;
+
+  static const int MAX_MESSAGE_SIZE{
+      128 + 8 * (Cfg::MAX_ROCKET_COUNT + Cfg::MAX_BOMB_COUNT)};
+
+  /// Takes the state of a game.
+  /// @param layout Enemies as placed by a reset.
+  void capture(GAMESTATE state, const Simulation &sim,
+               const typename Simulation::EnemyPool &layout);
+
+  /// Moves rockets and bombs like an update of the simulation.
+  void advance(double seconds);
+
+  /// Writes the message that turns a state into this one.
+  /// @param from The state of the receiver, already advanced by the tick.
+  /// Ignored for keyframes.
+  /// @param out At least MAX_MESSAGE_SIZE bytes.
+  /// @return Bytes written.
+  int encode(const SpectatorState &from, SPECTATOR_MESSAGE type,
+             int tickMicros, std::uint8_t *out) const;
+
+  /// Applies a message. Deltas before the first keyframe are ignored.
+  /// @return false if the message is malformed, the state is unsynced then.
+  bool apply(const std::uint8_t *data, int size);
+
+  /// Position of an alive enemy.
+  Position getEnemyPosition(const typename Simulation::EnemyPool &layout,
+                            int i) const;
+
+  bool operator==(const SpectatorState &o) const;
+
+  /// A keyframe was applied, deltas can follow
+  bool synced{false};
+
+  GAMESTATE gamestate{GAMESTATE::WELCOME};
+  int score{0};
+  int highscore{0};
+  int level{1};
+  Player player;
+  std::uint64_t enemiesAlive{0};
+  /// Offset of the formation in fixed point units
+  int enemyOffsetX{0};
+  int enemyOffsetY{0};
+  typename Simulation::RocketPool rockets;
+  typename Simulation::BombPool bombs;
+};
+
+/// Streams the state of a game to a viewer listening on a Unix domain
+/// datagram socket (see SpectatorViewer). Every tick sends one delta and
+/// every Cfg::SPECTATOR_KEYFRAME_TICKS ticks a keyframe. Sending never
+/// blocks; a message the viewer can't take is dropped and the next one is a
+/// keyframe. Bytes, messages, drops and the time spent are counted in the
+/// metrics.
+template <typename Cfg = Config>
+class SpectatorPublisher
+{
+public:
+  SpectatorPublisher(const std::string &path, MetricsRegistry &metrics);
+  ~SpectatorPublisher();
+
+  SpectatorPublisher(const SpectatorPublisher &) = delete;
+  SpectatorPublisher &operator=(const SpectatorPublisher &) = delete;
+
+  /// Sends the changes of the last tick.
+  /// @param seconds Time of the tick.
+  void publish(GAMESTATE state, const GameSimulation<Cfg> &sim,
+               double seconds);
+
+private:
+  /// Returns false if the viewer didn't take the message.
+  bool send(int size);
+
+  MetricsRegistry &_metrics;
+  std::string _path;
+  int _socket{-1};
+
+  typename GameSimulation<Cfg>::EnemyPool _layout;
+
+  /// State of the viewer and of the game
+  SpectatorState<Cfg> _sent;
+  SpectatorState<Cfg> _current;
+  int _ticksSinceKeyframe{0};
+  bool _keyframeDue{true};
+
+  std::array<std::uint8_t, SpectatorState<Cfg>::MAX_MESSAGE_SIZE> _message{};
+};
+
+// defined and instantiated in SpectatorStream.cpp
+extern template struct SpectatorState<Config>;
+extern template struct SpectatorState<HeadlessConfig>;
+extern template class SpectatorPublisher<Config>;
+extern template class SpectatorPublisher<HeadlessConfig>;
+
+#endif // SPECTATOR_STREAM_H__
@@ -0,0 +1,99 @@
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#define SPECTATOR_UNIX_SOCKET
+#endif
+
+#include "SpectatorViewer.h"
+
+SpectatorViewer::SpectatorViewer(const std::string &path)
+    : _path(path), _layout(GameSimulation<Config>{}.getEnemies())
+{
+#if defined(SPECTATOR_UNIX_SOCKET)
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if (_path.size() >= sizeof(address.sun_path))
+    return;
+  _path.copy(address.sun_path, _path.size());
+
+  // a socket left behind by a previous viewer would fail the bind
+  unlink(_path.c_str());
+  _socket = socket(AF_UNIX, SOCK_DGRAM, 0);
+  if (_socket >= 0 && bind(_socket, reinterpret_cast<sockaddr *>(&address),
+                           sizeof(address)) != 0)
+  {
+    close(_socket);
+    _socket = -1;
+  }
+#endif
+}
+
+SpectatorViewer::~SpectatorViewer()
+{
+#if defined(SPECTATOR_UNIX_SOCKET)
+  if (_socket >= 0)
+  {
+    close(_socket);
+    unlink(_path.c_str());
+  }
+#endif
+}
+
+void SpectatorViewer::receive()
+{
+#if defined(SPECTATOR_UNIX_SOCKET)
+  if (_socket < 0)
+    return;
+
+  for (;;)
+  {
+    ssize_t size =
+        recv(_socket, _message.data(), _message.size(), MSG_DONTWAIT);
+    if (size < 0)
+      break;
+
+    ++_receivedMessages;
+    _receivedBytes += size;
+    // an invalid message unsyncs the state until the next keyframe
+    if (size == static_cast<ssize_t>(_message.size()) ||
+        !_state.apply(_message.data(), static_cast<int>(size)))
+    {
+      _state.synced = false;
+      ++_invalidMessages;
+    }
+  }
+#endif
+}
+
+void SpectatorViewer::draw()
+{
+  _canvas.beginFrame();
+  if (_state.synced)
+    drawState();
+  else
+    _canvas.drawCenteredText("Waiting for the game");
+
+#if defined(SOFTWARE_RENDERER)
+  _renderer.beginFrame();
+#endif
+  _canvas.submit();
+#if defined(SOFTWARE_RENDERER)
+  _renderer.present();
+#endif
+}
+
+void SpectatorViewer::drawState()
+{
+  _canvas.drawObject(Engine::Sprite::Player, _state.player.getPosition());
+  for (int i : AliveIndices{_state.enemiesAlive})
+    _canvas.drawEnemy(i, _state.getEnemyPosition(_layout, i));
+  _canvas.drawObjects(Engine::Sprite::Rocket, _state.rockets);
+  _canvas.drawObjects(Engine::Sprite::Bomb, _state.bombs);
+
+  _canvas.drawHealth(_state.player.getHealth());
+  _canvas.drawScores(_state.score, _state.highscore);
+  _canvas.drawText("Spectating", 0, CanvasHeight - FontRowHeight);
+  // the viewer does not know when the game shows the prompt to try again
+  _canvas.drawMessage(_state.gamestate, false);
+}
@@ -0,0 +1,85 @@
+#ifndef SPECTATOR_VIEWER_H__
+#define SPECTATOR_VIEWER_H__
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+#include "Engine.h"
+#include "FrameArena.h"
+#include "SceneCanvas.h"
+#include "SpectatorStream.h"
+
+#if defined(SOFTWARE_RENDERER)
+#include "SoftwareRenderer.h"
+#endif
+
+/// Shows a game that another instance streams with a SpectatorPublisher.
+/// It listens on a Unix domain datagram socket, rebuilds the state from the
+/// messages and draws it like the game does.
+class SpectatorViewer : private Engine
+{
+public:
+  /// @param path Socket the publisher sends to, created by the viewer.
+  explicit SpectatorViewer(const std::string &path);
+  ~SpectatorViewer();
+
+  SpectatorViewer(const SpectatorViewer &) = delete;
+  SpectatorViewer &operator=(const SpectatorViewer &) = delete;
+
+  /// Returns false if the viewer should quit.
+  bool startFrame()
+  {
+    _frameArena.reset();
+    return Engine::startFrame();
+  }
+
+  /// Applies all messages that arrived since the last frame.
+  void receive();
+
+  /// Draws the rebuilt state.
+  void draw();
+
+  /// Bytes and messages received, and messages that could not be applied.
+  std::int64_t getReceivedBytes() const { return _receivedBytes; }
+  std::int64_t getReceivedMessages() const { return _receivedMessages; }
+  std::int64_t getInvalidMessages() const { return _invalidMessages; }
+
+#if defined(SOFTWARE_RENDERER)
+  /// The renderer the viewer draws to, like GameEngine::getRenderer. The
+  /// host has to provide the sprite and glyph images.
+  SoftwareRenderer &getRenderer() { return _renderer; }
+#endif
+
+private:
+  /// Draws the rebuilt state, once it is synced.
+  void drawState();
+
+  std::string _path;
+  int _socket{-1};
+
+  GameSimulation<Config>::EnemyPool _layout;
+  SpectatorState<Config> _state;
+
+  // one byte more than a valid message, so oversized ones are detected
+  std::array<std::uint8_t, SpectatorState<Config>::MAX_MESSAGE_SIZE + 1>
+      _message{};
+
+  std::int64_t _receivedBytes{0};
+  std::int64_t _receivedMessages{0};
+  std::int64_t _invalidMessages{0};
+
+  /// Draw list of the frame, reset in startFrame
+  FrameArena _frameArena;
+
+#if defined(SOFTWARE_RENDERER)
+  /// Draws like the game, to a software renderer
+  SoftwareRenderer _renderer;
+  SceneCanvas _canvas{*this, _frameArena, _renderer};
+#else
+  /// Draws like the game, with the engine
+  SceneCanvas _canvas{*this, _frameArena};
+#endif
+};
+
+#endif // SPECTATOR_VIEWER_H__
@@ -0,0 +1,55 @@
+#ifndef SPSC_RING_H__
+#define SPSC_RING_H__
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+/// Bounded lock-free queue for exactly one producer and one consumer thread.
+/// Push and pop never block, they fail if the ring is full or empty.
+template <typename T, size_t CAPACITY>
+class SpscRing
+{
+  static_assert(CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0,
+                "CAPACITY must be a power of two");
+
+public:
+  /// Producer only. Returns false if the ring is full.
+  bool push(const T &value)
+  {
+    size_t head = _head.load(std::memory_order_relaxed);
+    if (head - _tail.load(std::memory_order_acquire) == CAPACITY)
+      return false;
+
+    _items[head & (CAPACITY - 1)] = value;
+    _head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// Consumer only. Returns false if the ring is empty.
+  bool pop(T &value)
+  {
+    size_t tail = _tail.load(std::memory_order_relaxed);
+    if (tail == _head.load(std::memory_order_acquire))
+      return false;
+
+    value = _items[tail & (CAPACITY - 1)];
+    _tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool empty() const
+  {
+    return _tail.load(std::memory_order_acquire) ==
+           _head.load(std::memory_order_acquire);
+  }
+
+private:
+  // head and tail on their own cache lines, so producer and consumer don't
+  // invalidate each other's line on every access
+  alignas(64) std::atomic<size_t> _head{0};
+  alignas(64) std::atomic<size_t> _tail{0};
+  alignas(64) std::array<T, CAPACITY> _items{};
+};
+
+#endif // SPSC_RING_H__
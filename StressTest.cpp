@@ -0,0 +1,290 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+#include "StressTest.h"
+
+const int StressTest::OBJECTS_PER_FORMATION;
+const int StressTest::ConfigComparison::ROUNDS;
+
+int RuntimeConfig::ENEMY_ROWS{0};
+int RuntimeConfig::ENEMY_COLS{0};
+int RuntimeConfig::PLAYER_HEALTH{0};
+double RuntimeConfig::TIME_BETWEEN_SHOTS{0.0};
+double RuntimeConfig::TIME_BETWEEN_BOMBS{0.0};
+
+using StressClock = std::chrono::steady_clock;
+
+/// Returns the seconds since start and moves start to now.
+static double lap(StressClock::time_point &start)
+{
+  StressClock::time_point now = StressClock::now();
+  double seconds = std::chrono::duration<double>(now - start).count();
+  start = now;
+  return seconds;
+}
+
+StressTest::Footprint StressTest::getFootprint()
+{
+  // common size of a per core L2 cache, if the system doesn't tell
+  long l2Bytes{256 * 1024};
+#if defined(_SC_LEVEL2_CACHE_SIZE)
+  if (sysconf(_SC_LEVEL2_CACHE_SIZE) > 0)
+    l2Bytes = sysconf(_SC_LEVEL2_CACHE_SIZE);
+#endif
+
+  Footprint footprint;
+  footprint.objectBytes = sizeof(GameObject);
+  footprint.sceneBytes = sizeof(GameSimulation<Config>::EnemyPool) +
+                         sizeof(GameSimulation<Config>::RocketPool) +
+                         sizeof(GameSimulation<Config>::BombPool) +
+                         sizeof(Player);
+  footprint.gameBytes = sizeof(GameSimulation<Config>);
+  footprint.formationBytes = sizeof(Simulation);
+  footprint.l2Bytes = l2Bytes;
+  footprint.gamesPerL2 = l2Bytes / footprint.gameBytes;
+  footprint.formationsPerL2 = l2Bytes / footprint.formationBytes;
+  return footprint;
+}
+
+/// Plays games with full ticks until the given ticks or, if 0, the seconds
+/// passed. Returns the wall time, the ticks played and a checksum of the
+/// scores.
+template <typename Cfg>
+static double playGames(int games, double seconds, int &ticks,
+                        std::int64_t &checksum)
+{
+  const double tickSeconds{1.0 / 60};
+  const bool untilSeconds = ticks == 0;
+
+  std::vector<GameSimulation<Cfg>> sims(games);
+  double now{0.0};
+  for (int g = 0; g < games; ++g)
+  {
+    sims[g].seed(g + 1);
+    sims[g].start(now);
+  }
+
+  checksum = 0;
+  int tick{0};
+  const StressClock::time_point start = StressClock::now();
+  while (untilSeconds
+             ? std::chrono::duration<double>(StressClock::now() - start)
+                       .count() < seconds
+             : tick < ticks)
+  {
+    now += tickSeconds;
+    for (int g = 0; g < games; ++g)
+    {
+      GameSimulation<Cfg> &sim = sims[g];
+      bool left = ((tick + g * 37) / 120) % 2 == 0;
+      sim.tick({left, !left, true}, true, now, tickSeconds);
+      if (sim.isGameOver())
+      {
+        checksum += sim.getHighscore().getCurrentScore();
+        sim.reset();
+        sim.getHighscore().finishScore();
+      }
+    }
+    ++tick;
+  }
+  const double elapsed =
+      std::chrono::duration<double>(StressClock::now() - start).count();
+
+  for (const GameSimulation<Cfg> &sim : sims)
+    checksum += sim.getHighscore().getCurrentScore() + sim.getLevel();
+  ticks = tick;
+  return elapsed;
+}
+
+/// Middle value, sorts the values.
+static double median(std::vector<double> &values)
+{
+  std::sort(values.begin(), values.end());
+  const size_t middle = values.size() / 2;
+  return values.size() % 2 ? values[middle]
+                           : (values[middle - 1] + values[middle]) / 2;
+}
+
+StressTest::ConfigComparison StressTest::compareConfigs(int games,
+                                                        double seconds)
+{
+  // set at run time, the compiler can't fold them into the code
+  RuntimeConfig::ENEMY_ROWS = Config::ENEMY_ROWS;
+  RuntimeConfig::ENEMY_COLS = Config::ENEMY_COLS;
+  RuntimeConfig::PLAYER_HEALTH = Config::PLAYER_HEALTH;
+  RuntimeConfig::TIME_BETWEEN_SHOTS = Config::TIME_BETWEEN_SHOTS;
+  RuntimeConfig::TIME_BETWEEN_BOMBS = Config::TIME_BETWEEN_BOMBS;
+
+  using PlayGames = double (*)(int, double, int &, std::int64_t &);
+  const std::array<PlayGames, 4> plays{
+      {playGames<Config>, playGames<RuntimeConfig>, playGames<DoubleConfig>,
+       playGames<BruteForceConfig>}};
+  const int rounds{ConfigComparison::ROUNDS};
+
+  ConfigComparison result;
+  result.games = std::max(games, 1);
+  result.variants[0].name = "RuntimeConfig";
+  result.variants[1].name = "DoubleConfig";
+  result.variants[2].name = "BruteForceConfig";
+
+  // the first run finds the ticks. Then every round plays all
+  // configurations, each round starts with another one, so clock changes
+  // and the order don't favor one of them.
+  std::array<std::int64_t, 4> checksums{};
+  plays[0](result.games, seconds / rounds, result.ticks, checksums[0]);
+  std::array<std::vector<double>, 4> times;
+  for (int round = 0; round < rounds; ++round)
+  {
+    for (size_t k = 0; k < plays.size(); ++k)
+    {
+      const size_t c = (round + k) % plays.size();
+      times[c].push_back(
+          plays[c](result.games, 0.0, result.ticks, checksums[c]));
+    }
+  }
+
+  const double gameTicks = static_cast<double>(result.games) * result.ticks;
+  for (size_t v = 0; v < result.variants.size(); ++v)
+  {
+    // the change within a round, both ran at about the same time
+    std::vector<double> changes;
+    for (int round = 0; round < rounds; ++round)
+      changes.push_back((times[v + 1][round] / times[0][round] - 1.0) * 100);
+    ConfigVariant &variant = result.variants[v];
+    variant.change = median(changes);
+    variant.minChange = changes.front();
+    variant.maxChange = changes.back();
+    variant.seconds = median(times[v + 1]) / gameTicks;
+    variant.sameGames = checksums[v + 1] == checksums[0];
+  }
+  result.specializedSeconds = median(times[0]) / gameTicks;
+  return result;
+}
+
+/// Repeats a call in batches until the time is up, returns the seconds per
+/// call.
+template <typename Call>
+static double timeCalls(double seconds, Call call)
+{
+  const int batch{10000};
+  std::int64_t calls{0};
+  const StressClock::time_point start = StressClock::now();
+  double elapsed{0.0};
+  do
+  {
+    for (int i = 0; i < batch; ++i)
+      call(i);
+    calls += batch;
+    elapsed = std::chrono::duration<double>(StressClock::now() - start).count();
+  } while (elapsed < seconds);
+  return elapsed / calls;
+}
+
+StressTest::MetricsCost StressTest::measureMetrics(double seconds)
+{
+  MetricsRegistry metrics;
+  MetricsCost result;
+  result.addSeconds = timeCalls(seconds / 3, [&metrics](int i) {
+    metrics.add(METRIC::BOT_SIMULATED_TICKS, i);
+  });
+  result.setSeconds = timeCalls(seconds / 3, [&metrics](int i) {
+    metrics.set(METRIC::ENEMIES_ALIVE, i);
+  });
+  result.timerSeconds = timeCalls(seconds / 3, [&metrics](int) {
+    ScopedMetricTimer timer{metrics, METRIC::DRAW_SECONDS};
+  });
+  return result;
+}
+
+StressTest::Result StressTest::run(int objects, double seconds)
+{
+  // even short runs need a few ticks for stable averages
+  const int minTicks{10};
+  const double tickSeconds{1.0 / 60};
+
+  Result result;
+  result.formations = std::max(1, objects / OBJECTS_PER_FORMATION);
+  result.capacity = result.formations * OBJECTS_PER_FORMATION;
+
+  // every formation drops its bombs in its own order
+  double now{0.0};
+  _formations.assign(result.formations, Simulation{});
+  for (int f = 0; f < result.formations; ++f)
+  {
+    _formations[f].seed(f + 1);
+    _formations[f].start(now);
+  }
+
+  std::int64_t aliveSum{0};
+  int aliveSamples{0};
+  const StressClock::time_point runStart = StressClock::now();
+  while (result.ticks < minTicks ||
+         std::chrono::duration<double>(StressClock::now() - runStart)
+                 .count() < seconds)
+  {
+    now += tickSeconds;
+    StressClock::time_point start = StressClock::now();
+
+    for (int f = 0; f < result.formations; ++f)
+    {
+      Simulation &sim = _formations[f];
+      sim.advanceTime(now);
+      // the players sweep across the canvas, each with its own phase
+      bool left = ((result.ticks + f * 37) / 120) % 2 == 0;
+      sim.movePlayer({left, !left, true}, tickSeconds);
+      sim.fire(now);
+    }
+    result.inputSeconds += lap(start);
+
+    for (Simulation &sim : _formations)
+    {
+      sim.beginUpdate(now, tickSeconds);
+      sim.updateEnemies();
+    }
+    result.enemiesSeconds += lap(start);
+
+    for (Simulation &sim : _formations)
+      sim.updateBombs();
+    result.bombsSeconds += lap(start);
+
+    for (Simulation &sim : _formations)
+      sim.updateRockets();
+    result.rocketsSeconds += lap(start);
+
+    // restarts and samples are not part of a tick
+    for (Simulation &sim : _formations)
+    {
+      if (sim.isGameOver())
+      {
+        sim.reset();
+        ++result.restarts;
+      }
+    }
+    if (result.ticks % 16 == 0)
+    {
+      for (const Simulation &sim : _formations)
+      {
+        aliveSum += sim.getEnemies().count() + sim.getRockets().count() +
+                    sim.getBombs().count() + (sim.getPlayer().isAlive());
+      }
+      ++aliveSamples;
+    }
+    ++result.ticks;
+  }
+
+  const double tickTotal = result.inputSeconds + result.enemiesSeconds +
+                           result.bombsSeconds + result.rocketsSeconds;
+  result.ticksPerSecond = result.ticks / tickTotal;
+  result.inputSeconds /= result.ticks;
+  result.enemiesSeconds /= result.ticks;
+  result.bombsSeconds /= result.ticks;
+  result.rocketsSeconds /= result.ticks;
+  result.aliveObjects = static_cast<double>(aliveSum) / aliveSamples;
+  return result;
+}
@@ -0,0 +1,120 @@
+#ifndef STRESS_TEST_H__
+#define STRESS_TEST_H__
+
+#include <array>
+#include <vector>
+
+#include "Config.h"
+#include "GameSimulation.h"
+#include "Metrics.h"
+
+/// Measures how the update of the game scales with the number of objects.
+/// It runs many independent formations, each a GameSimulation<StressConfig>
+/// with its own enemies, bounding boxes, direction, player, rockets and
+/// bombs. The players keep moving and shooting. A formation whose game is
+/// over starts again. Every phase runs over all formations before the next
+/// one starts and is timed on its own. Nothing is drawn.
+class StressTest
+{
+public:
+  using Simulation = GameSimulation<StressConfig>;
+
+  /// Objects a formation can hold: enemies, rockets, bombs and the player.
+  static const int OBJECTS_PER_FORMATION{StressConfig::ENEMY_COUNT +
+                                         StressConfig::MAX_ROCKET_COUNT +
+                                         StressConfig::MAX_BOMB_COUNT + 1};
+
+  struct Result
+  {
+    int formations{0};
+    /// Objects the formations can hold, and the average that were alive
+    int capacity{0};
+    double aliveObjects{0.0};
+    int ticks{0};
+    double ticksPerSecond{0.0};
+    /// Average seconds per tick of the input (timers, movement, shots) and
+    /// the update phases
+    double inputSeconds{0.0};
+    double enemiesSeconds{0.0};
+    double bombsSeconds{0.0};
+    double rocketsSeconds{0.0};
+    /// Formations that were restarted after their game was over
+    int restarts{0};
+  };
+
+  /// Memory a game state takes, and how many fit in the L2 cache.
+  struct Footprint
+  {
+    int objectBytes{0};
+    /// Enemies, rockets, bombs and player of the game, without timers
+    int sceneBytes{0};
+    /// A GameSimulation of the game and of a formation
+    int gameBytes{0};
+    int formationBytes{0};
+    long l2Bytes{0};
+    long gamesPerL2{0};
+    long formationsPerL2{0};
+  };
+
+  /// A configuration that differs from Config in one policy or value,
+  /// measured against it.
+  struct ConfigVariant
+  {
+    const char *name{""};
+    /// Median seconds per game tick
+    double seconds{0.0};
+    /// Median, lowest and highest change against Config in the same round,
+    /// in percent. A range that includes 0 is noise.
+    double change{0.0};
+    double minChange{0.0};
+    double maxChange{0.0};
+    /// Played the same games as Config
+    bool sameGames{false};
+  };
+
+  /// Time per game tick of the same games, played with Config and its
+  /// variants: RuntimeConfig (values only known at run time), DoubleConfig
+  /// (numeric type) and BruteForceConfig (collision policy).
+  struct ConfigComparison
+  {
+    /// Rounds of compareConfigs, every round plays all configurations once
+    static const int ROUNDS{9};
+
+    int games{0};
+    int ticks{0};
+    /// Median seconds per game tick with Config
+    double specializedSeconds{0.0};
+    std::array<ConfigVariant, 3> variants;
+  };
+
+  /// Seconds per call of the metrics on the hot path, on one thread.
+  struct MetricsCost
+  {
+    double addSeconds{0.0};
+    double setSeconds{0.0};
+    /// A ScopedMetricTimer, two clock reads and an add
+    double timerSeconds{0.0};
+  };
+
+  static Footprint getFootprint();
+
+  /// Plays the same games with GameSimulation<Config> and its variants.
+  /// @param seconds Wall time of the first run with Config, the ticks it
+  /// played are played ConfigComparison::ROUNDS more times with each
+  /// configuration, in a different order every round.
+  static ConfigComparison compareConfigs(int games, double seconds);
+
+  /// Calls MetricsRegistry::add, set and ScopedMetricTimer in a loop, each
+  /// for a third of the given wall time.
+  static MetricsCost measureMetrics(double seconds);
+
+  /// Runs as many whole formations as the given number of objects fill, at
+  /// least one. Result::capacity is the number of objects they hold.
+  /// @param seconds Minimum wall time of the run.
+  Result run(int objects, double seconds);
+
+private:
+  std::vector<Simulation> _formations;
+};
+
+#endif // STRESS_TEST_H__
@@ -0,0 +1,226 @@
+#ifndef TIMER_WHEEL_H__
+#define TIMER_WHEEL_H__
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+/// Hierarchical timing wheel for a fixed set of timers. Every timer is
+/// identified by an enum value below CAPACITY and can be pending at most once,
+/// scheduling it again moves its deadline.
+///
+/// Deadlines within 64 ticks go to the inner wheel, those within 64 * 64
+/// ticks to the outer wheel and all others to a list of later timers. The
+/// outer wheel and the later list are moved inwards when the inner wheel wraps.
+/// Advancing therefore only touches the slots of the passed ticks and the
+/// timers that expire, not all pending timers.
+///
+/// The ticks only sort the timers, a timer expires at its exact deadline. One
+/// whose deadline lies within the current tick stays in its slot until an
+/// advance reaches the deadline.
+///
+/// The wheel is plain data without pointers, so it can be copied together
+/// with the state it belongs to.
+template <typename ID, int CAPACITY>
+class TimerWheel
+{
+public:
+  /// @param tickSeconds Resolution of the deadlines.
+  explicit TimerWheel(double tickSeconds = 0.01) : _tickSeconds(tickSeconds)
+  {
+    _inner.fill(NONE);
+    _outer.fill(NONE);
+  }
+
+  /// Sets the current time without firing any timer.
+  void start(double now) { _currentTick = toTick(now); }
+
+  /// Schedules a timer at an absolute time. Deadlines that already passed
+  /// expire on the next advance.
+  void schedule(ID id, double deadline)
+  {
+    int index = static_cast<int>(id);
+    cancel(id);
+
+    Entry &e = _entries[index];
+    e.time = deadline;
+    e.deadline = std::max(toTick(deadline), _currentTick);
+    e.pending = true;
+    insert(index);
+  }
+
+  void cancel(ID id)
+  {
+    int index = static_cast<int>(id);
+    if (_entries[index].pending)
+    {
+      unlink(index);
+      _entries[index].pending = false;
+    }
+  }
+
+  bool isPending(ID id) const
+  {
+    return _entries[static_cast<int>(id)].pending;
+  }
+
+  /// Moves the time forward and calls onExpired(ID) for every timer whose
+  /// deadline is at or before now, in order of their ticks. The callback may
+  /// schedule timers again, those expire on the next advance at the earliest.
+  template <typename F>
+  void advance(double now, F &&onExpired)
+  {
+    // timers left in the current tick by the last advance
+    expire(now, onExpired);
+
+    const std::int64_t target = toTick(now);
+    while (_currentTick < target)
+    {
+      ++_currentTick;
+      if ((_currentTick & (SLOTS - 1)) == 0)
+        cascade();
+      expire(now, onExpired);
+    }
+  }
+
+private:
+  static const int SLOTS{64};
+  static const int NONE{-1};
+
+  enum class LIST : std::int8_t
+  {
+    INNER,
+    OUTER,
+    LATER
+  };
+
+  struct Entry
+  {
+    double time{0.0};
+    std::int64_t deadline{0};
+    int prev{NONE};
+    int next{NONE};
+    LIST list{LIST::INNER};
+    std::int8_t slot{0};
+    bool pending{false};
+  };
+
+  /// Calls onExpired for the timers of the current tick that are due. The
+  /// timers of earlier ticks always are, their deadlines lie before now.
+  template <typename F>
+  void expire(double now, F &onExpired)
+  {
+    const int slot = static_cast<int>(_currentTick & (SLOTS - 1));
+
+    // collect first, the callback may change the slot
+    std::array<int, CAPACITY> expired;
+    int expiredCount{0};
+    for (int i = _inner[slot]; i != NONE; i = _entries[i].next)
+    {
+      const Entry &e = _entries[i];
+      if (e.deadline <= _currentTick && e.time <= now)
+        expired[expiredCount++] = i;
+    }
+
+    for (int n = 0; n < expiredCount; ++n)
+    {
+      int index = expired[n];
+      unlink(index);
+      _entries[index].pending = false;
+      onExpired(static_cast<ID>(index));
+    }
+  }
+
+  std::int64_t toTick(double seconds) const
+  {
+    return static_cast<std::int64_t>(std::floor(seconds / _tickSeconds));
+  }
+
+  int &head(LIST list, int slot)
+  {
+    if (list == LIST::INNER)
+      return _inner[slot];
+    if (list == LIST::OUTER)
+      return _outer[slot];
+    return _later;
+  }
+
+  void insert(int index)
+  {
+    Entry &e = _entries[index];
+    const std::int64_t block = e.deadline / SLOTS;
+    const std::int64_t currentBlock = _currentTick / SLOTS;
+    if (e.deadline - _currentTick < SLOTS)
+    {
+      e.list = LIST::INNER;
+      e.slot = static_cast<std::int8_t>(e.deadline & (SLOTS - 1));
+    }
+    else if (block - currentBlock < SLOTS)
+    {
+      e.list = LIST::OUTER;
+      e.slot = static_cast<std::int8_t>(block & (SLOTS - 1));
+    }
+    else
+    {
+      e.list = LIST::LATER;
+      e.slot = 0;
+    }
+
+    int &first = head(e.list, e.slot);
+    e.prev = NONE;
+    e.next = first;
+    if (first != NONE)
+      _entries[first].prev = index;
+    first = index;
+  }
+
+  void unlink(int index)
+  {
+    Entry &e = _entries[index];
+    if (e.prev != NONE)
+      _entries[e.prev].next = e.next;
+    else
+      head(e.list, e.slot) = e.next;
+    if (e.next != NONE)
+      _entries[e.next].prev = e.prev;
+    e.prev = NONE;
+    e.next = NONE;
+  }
+
+  /// Moves the timers of the outer slot of the new block (and on a full turn
+  /// the later list) inwards.
+  void cascade()
+  {
+    const std::int64_t block = _currentTick / SLOTS;
+    if ((block & (SLOTS - 1)) == 0)
+      reinsertAll(_later);
+    reinsertAll(_outer[block & (SLOTS - 1)]);
+  }
+
+  void reinsertAll(int &first)
+  {
+    int i = first;
+    first = NONE;
+    while (i != NONE)
+    {
+      int next = _entries[i].next;
+      insert(i);
+      i = next;
+    }
+  }
+
+  double _tickSeconds;
+  std::int64_t _currentTick{0};
+  std::array<Entry, CAPACITY> _entries{};
+  std::array<int, SLOTS> _inner;
+  std::array<int, SLOTS> _outer;
+  int _later{NONE};
+};
+
+template <typename ID, int CAPACITY>
+const int TimerWheel<ID, CAPACITY>::SLOTS;
+template <typename ID, int CAPACITY>
+const int TimerWheel<ID, CAPACITY>::NONE;
+
+#endif // TIMER_WHEEL_H__